@@ -0,0 +1,421 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/memstream.h"
+#include "common/random.h"
+#include "common/system.h"
+
+#include "cryo/benchmark.h"
+#include "cryo/blit.h"
+#include "cryo/cryo.h"
+#include "cryo/font.h"
+#include "cryo/hsq.h"
+#include "cryo/resource.h"
+#include "cryo/screen.h"
+#include "cryo/sentences.h"
+#include "cryo/sprite.h"
+
+namespace Cryo {
+
+// The size of a full screen frame, in pixels
+#define BENCHMARK_FRAME_SIZE (320 * 200)
+
+// Limits the amount of packed data which is kept in memory for the HSQ tests
+#define BENCHMARK_CORPUS_SIZE (4 * 1024 * 1024)
+
+static const char *const benchmarkSprites[] = {
+	"intds.hsq",	// full screen background, stored unpacked
+	"generic.hsq",	// sprite font, RLE packed
+	"mirror.hsq",
+	0
+};
+
+static const char *const benchmarkText = "The quick brown fox jumps over the lazy dog 0123456789";
+
+Common::String BenchmarkResult::toString() const {
+	// Guard against timer granularity on very short runs
+	uint64 kbPerSecond = bytes / 1024 * 1000 / MAX<uint32>(millis, 1);
+
+	return Common::String::format("bench name=%s items=%d bytes=%llu ms=%d kbps=%llu",
+			name.c_str(), items, (unsigned long long)bytes, millis, (unsigned long long)kbPerSecond);
+}
+
+Benchmark::Benchmark(CryoEngine *engine) : _engine(engine) {
+}
+
+void Benchmark::run(uint iterations, Common::Array<BenchmarkResult> &results) {
+	loadCorpus();
+
+	results.push_back(benchHsqStream(iterations));
+	results.push_back(benchHsqBuffer(iterations));
+	results.push_back(benchSprites(iterations));
+	results.push_back(benchCachedSprites(iterations));
+	benchBlits(iterations, results);
+	benchNibbles(iterations, results);
+	results.push_back(benchFixedFont(iterations));
+	results.push_back(benchCachedText(iterations));
+	results.push_back(benchRenderText(iterations));
+	results.push_back(benchSentences(iterations));
+}
+
+void Benchmark::loadCorpus() {
+	ResourceManager *resMan = _engine->getResourceManager();
+	Common::StringArray fileNames;
+	resMan->listResources(fileNames);
+
+	_packed.clear();
+	_phraseFiles.clear();
+
+	uint32 corpusSize = 0;
+	for (uint i = 0; i < fileNames.size(); i++) {
+		Common::String fileName = fileNames[i];
+		fileName.toLowercase();
+
+		if (fileName.hasPrefix("phrase") && fileName.hasSuffix(".hsq"))
+			_phraseFiles.push_back(fileName);
+
+		if (corpusSize >= BENCHMARK_CORPUS_SIZE)
+			continue;
+
+		Common::SeekableReadStream *rsrc = resMan->getRawResource(fileName);
+		byte header[6];
+		uint16 unpackedSize, packedSize;
+
+		if (rsrc->read(header, 6) == 6 && parseHsqHeader(header, unpackedSize, packedSize) && packedSize == rsrc->size()) {
+			PackedResource resource;
+			resource.fileName = fileName;
+			resource.unpackedSize = unpackedSize;
+			resource.data.resize(packedSize - 6);
+			rsrc->read(resource.data.begin(), packedSize - 6);
+			_packed.push_back(resource);
+			corpusSize += packedSize;
+		}
+
+		delete rsrc;
+	}
+}
+
+BenchmarkResult Benchmark::benchHsqStream(uint iterations) {
+	BenchmarkResult result;
+	result.name = "hsq_stream";
+	result.items = 0;
+	result.bytes = 0;
+
+	byte *output = new byte[0x10000];
+	uint32 start = g_system->getMillis();
+
+	for (uint i = 0; i < iterations; i++) {
+		for (uint j = 0; j < _packed.size(); j++) {
+			Common::MemoryReadStream source(_packed[j].data.begin(), _packed[j].data.size());
+			HsqReadStream hsq(&source);
+			result.bytes += hsq.read(output, _packed[j].unpackedSize);
+			result.items++;
+		}
+	}
+
+	result.millis = g_system->getMillis() - start;
+	delete[] output;
+	return result;
+}
+
+BenchmarkResult Benchmark::benchHsqBuffer(uint iterations) {
+	BenchmarkResult result;
+	result.name = "hsq_buffer";
+	result.items = 0;
+	result.bytes = 0;
+
+	byte *output = new byte[0x10000];
+	uint32 start = g_system->getMillis();
+
+	for (uint i = 0; i < iterations; i++) {
+		for (uint j = 0; j < _packed.size(); j++) {
+			result.bytes += decompressHsq(_packed[j].data.begin(), _packed[j].data.size(), output, _packed[j].unpackedSize);
+			result.items++;
+		}
+	}
+
+	result.millis = g_system->getMillis() - start;
+	delete[] output;
+	return result;
+}
+
+BenchmarkResult Benchmark::benchSprites(uint iterations) {
+	BenchmarkResult result;
+	result.name = "sprite_decode";
+	result.items = 0;
+	result.bytes = 0;
+	result.millis = 0;
+
+	ResourceManager *resMan = _engine->getResourceManager();
+
+	for (uint s = 0; benchmarkSprites[s]; s++) {
+		if (!resMan->hasResource(benchmarkSprites[s]))
+			continue;
+
+		Sprite sprite(benchmarkSprites[s], _engine);
+		uint16 frameCount = sprite.getFrameCount();
+		uint32 start = g_system->getMillis();
+
+		for (uint i = 0; i < iterations; i++) {
+			for (uint16 f = 0; f < frameCount; f++) {
+				DecodedFrame *frame = sprite.decodeFrame(f);
+				result.bytes += frame->width * frame->height;
+				delete frame;
+				result.items++;
+			}
+		}
+
+		result.millis += g_system->getMillis() - start;
+	}
+
+	return result;
+}
+
+BenchmarkResult Benchmark::benchCachedSprites(uint iterations) {
+	BenchmarkResult result;
+	result.name = "sprite_cached";
+	result.items = 0;
+	result.bytes = 0;
+	result.millis = 0;
+
+	ResourceManager *resMan = _engine->getResourceManager();
+
+	for (uint s = 0; benchmarkSprites[s]; s++) {
+		if (!resMan->hasResource(benchmarkSprites[s]))
+			continue;
+
+		// The first iteration fills the frame cache, the others hit it
+		Sprite sprite(benchmarkSprites[s], _engine);
+		uint16 frameCount = sprite.getFrameCount();
+		uint32 start = g_system->getMillis();
+
+		for (uint i = 0; i < iterations; i++) {
+			for (uint16 f = 0; f < frameCount; f++) {
+				DecodedFramePtr frame = sprite.getFrame(f);
+				result.bytes += frame->width * frame->height;
+				result.items++;
+			}
+		}
+
+		result.millis += g_system->getMillis() - start;
+	}
+
+	return result;
+}
+
+void Benchmark::benchBlits(uint iterations, Common::Array<BenchmarkResult> &results) {
+	ResourceManager *resMan = _engine->getResourceManager();
+	Common::Array<DecodedFrame *> frames;
+	Common::Array<DecodedFrame *> packedFrames;
+
+	for (uint s = 0; benchmarkSprites[s]; s++) {
+		if (!resMan->hasResource(benchmarkSprites[s]))
+			continue;
+
+		Sprite sprite(benchmarkSprites[s], _engine);
+		for (uint16 f = 0; f < sprite.getFrameCount(); f++) {
+			frames.push_back(sprite.decodeFrame(f));
+			packedFrames.push_back(sprite.decodeFrame(f, true));
+		}
+	}
+
+	// Draw into a separate back buffer, which is never shown
+	Screen screen(g_system);
+
+	// The first pass draws with the transparency mask, the second one with
+	// the span lists, and the last one draws the packed frames
+	static const char *const passNames[] = { "blit_mask", "blit_spans", "blit_packed" };
+
+	for (uint pass = 0; pass < 3; pass++) {
+		BenchmarkResult result;
+		result.name = passNames[pass];
+		result.items = 0;
+		result.bytes = 0;
+
+		if (pass == 1) {
+			for (uint f = 0; f < frames.size(); f++)
+				frames[f]->buildSpans();
+		}
+
+		Common::Array<DecodedFrame *> &passFrames = (pass == 2) ? packedFrames : frames;
+		uint32 start = g_system->getMillis();
+
+		for (uint i = 0; i < iterations; i++) {
+			for (uint f = 0; f < passFrames.size(); f++) {
+				screen.drawFrame(*passFrames[f], 0, 0);
+				result.bytes += passFrames[f]->width * passFrames[f]->height;
+				result.items++;
+			}
+		}
+
+		result.millis = g_system->getMillis() - start;
+		results.push_back(result);
+	}
+
+	for (uint f = 0; f < frames.size(); f++) {
+		delete frames[f];
+		delete packedFrames[f];
+	}
+}
+
+void Benchmark::benchNibbles(uint iterations, Common::Array<BenchmarkResult> &results) {
+	Common::RandomSource rnd("cryo_benchmark");
+	byte *source = new byte[BENCHMARK_FRAME_SIZE / 2];
+	byte *output = new byte[BENCHMARK_FRAME_SIZE];
+
+	for (uint32 j = 0; j < BENCHMARK_FRAME_SIZE / 2; j++)
+		source[j] = rnd.getRandomNumber(255);
+
+	// Every version the CPU supports is measured, the portable ones included
+	for (const NibbleExpander *expander = getNibbleExpanders(); expander->name; expander++) {
+		BenchmarkResult result;
+		result.name = Common::String("nibbles_") + expander->name;
+		result.items = 0;
+		result.bytes = 0;
+
+		uint32 start = g_system->getMillis();
+
+		// Repeat enough to get past the timer granularity
+		for (uint i = 0; i < iterations * 100; i++) {
+			expander->expand(source, output, BENCHMARK_FRAME_SIZE, i);
+			result.bytes += BENCHMARK_FRAME_SIZE;
+			result.items++;
+		}
+
+		result.millis = g_system->getMillis() - start;
+		results.push_back(result);
+	}
+
+	delete[] source;
+	delete[] output;
+}
+
+BenchmarkResult Benchmark::benchFixedFont(uint iterations) {
+	BenchmarkResult result;
+	result.name = "font_fixed";
+	result.items = 0;
+	result.bytes = 0;
+
+	Common::String charFile = _engine->isCD() ? "dnchar.bin" : "dunechar.hsq";
+	FixedFont font(charFile, _engine);
+	Common::String text(benchmarkText);
+
+	// Draw into a separate back buffer, which is never shown
+	Screen screen(g_system);
+
+	// Every iteration draws a screen full of text
+	uint32 start = g_system->getMillis();
+
+	for (uint i = 0; i < iterations; i++) {
+		for (uint16 y = 0; y + 10 <= 200; y += 10) {
+			font.drawText(*screen.getSurface(), screen.getClipRect(), text, 0, y, 15);
+			result.bytes += text.size();
+			result.items++;
+		}
+	}
+
+	result.millis = g_system->getMillis() - start;
+	return result;
+}
+
+BenchmarkResult Benchmark::benchCachedText(uint iterations) {
+	BenchmarkResult result;
+	result.name = "font_cached";
+	result.items = 0;
+	result.bytes = 0;
+
+	Common::String charFile = _engine->isCD() ? "dnchar.bin" : "dunechar.hsq";
+	FixedFont font(charFile, _engine);
+	Common::String text(benchmarkText);
+	Screen screen(g_system);
+
+	// The same screen full of text as the fixed font test, with the string
+	// rendered only for the first line
+	uint32 start = g_system->getMillis();
+
+	for (uint i = 0; i < iterations; i++) {
+		for (uint16 y = 0; y + 10 <= 200; y += 10) {
+			screen.drawFrame(*font.renderText(text, 15), 0, y);
+			result.bytes += text.size();
+			result.items++;
+		}
+	}
+
+	result.millis = g_system->getMillis() - start;
+	return result;
+}
+
+BenchmarkResult Benchmark::benchRenderText(uint iterations) {
+	BenchmarkResult result;
+	result.name = "font_render";
+	result.items = 0;
+	result.bytes = 0;
+
+	Common::String charFile = _engine->isCD() ? "dnchar.bin" : "dunechar.hsq";
+	FixedFont font(charFile, _engine);
+	Screen screen(g_system);
+
+	// The same screen full of text as the cached text test, but every line
+	// is different, so that all of them miss the caches and are rendered
+	Common::StringArray lines;
+	for (uint i = 0; i < iterations; i++) {
+		for (uint16 y = 0; y + 10 <= 200; y += 10)
+			lines.push_back(Common::String::format("%s %d %d", benchmarkText, i, y));
+	}
+
+	uint32 start = g_system->getMillis();
+
+	for (uint i = 0; i < lines.size(); i++) {
+		screen.drawFrame(*font.renderText(lines[i], 15), 0, (i % 20) * 10);
+		result.bytes += lines[i].size();
+		result.items++;
+	}
+
+	result.millis = g_system->getMillis() - start;
+	return result;
+}
+
+BenchmarkResult Benchmark::benchSentences(uint iterations) {
+	BenchmarkResult result;
+	result.name = "sentences";
+	result.items = 0;
+	result.bytes = 0;
+	result.millis = 0;
+
+	for (uint p = 0; p < _phraseFiles.size(); p++) {
+		Sentences sentences(_phraseFiles[p], _engine);
+		uint32 start = g_system->getMillis();
+
+		for (uint i = 0; i < iterations; i++) {
+			for (uint16 s = 0; s < sentences.count(); s++) {
+				result.bytes += sentences.getSentence(s, true).size();
+				result.items++;
+			}
+		}
+
+		result.millis += g_system->getMillis() - start;
+	}
+
+	return result;
+}
+
+} // End of namespace Cryo
@@ -0,0 +1,86 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_BENCHMARK_H
+#define CRYO_BENCHMARK_H
+
+#include "common/array.h"
+#include "common/str.h"
+
+namespace Cryo {
+
+class CryoEngine;
+
+struct BenchmarkResult {
+	Common::String name;
+	uint32 items;	// resources, frames, strings or sentences processed
+	uint64 bytes;	// bytes of output produced, which can pass 4GB with many iterations
+	uint32 millis;
+
+	/**
+	 * Formats the result as a single line of key=value pairs, so that the
+	 * output can easily be parsed by scripts
+	 */
+	Common::String toString() const;
+};
+
+/**
+ * Measures the throughput of the engine's decoders on the game data
+ */
+class Benchmark {
+public:
+	Benchmark(CryoEngine *engine);
+
+	/**
+	 * Runs all the benchmarks. Every test goes over its data <iterations> times.
+	 */
+	void run(uint iterations, Common::Array<BenchmarkResult> &results);
+
+private:
+	void loadCorpus();
+
+	BenchmarkResult benchHsqStream(uint iterations);
+	BenchmarkResult benchHsqBuffer(uint iterations);
+	BenchmarkResult benchSprites(uint iterations);
+	BenchmarkResult benchCachedSprites(uint iterations);
+	void benchBlits(uint iterations, Common::Array<BenchmarkResult> &results);
+	void benchNibbles(uint iterations, Common::Array<BenchmarkResult> &results);
+	BenchmarkResult benchFixedFont(uint iterations);
+	BenchmarkResult benchCachedText(uint iterations);
+	BenchmarkResult benchRenderText(uint iterations);
+	BenchmarkResult benchSentences(uint iterations);
+
+	CryoEngine *_engine;
+
+	struct PackedResource {
+		Common::String fileName;
+		Common::Array<byte> data;	// without the HSQ header
+		uint16 unpackedSize;
+	};
+
+	Common::Array<PackedResource> _packed;
+	Common::StringArray _phraseFiles;
+};
+
+} // End of namespace Cryo
+
+#endif
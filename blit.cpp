@@ -0,0 +1,384 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/surface.h"
+
+#include "cryo/blit.h"
+#include "cryo/framecache.h"
+
+// The vectorized versions of expandNibbles() are always built, with the
+// instruction set enabled for their functions only, and the one to use is
+// picked at run time. This way builds for the baseline of an architecture
+// still use the vector units of the CPUs which have them.
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <emmintrin.h>
+#define CRYO_BLIT_SSE2
+#define CRYO_TARGET_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <emmintrin.h>
+#include <intrin.h>
+#define CRYO_BLIT_SSE2
+#define CRYO_TARGET_SSE2
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+// NEON is part of ARMv8, and of 32-bit builds which enable it
+#include <arm_neon.h>
+#define CRYO_BLIT_NEON
+#define CRYO_TARGET_NEON
+#elif defined(__arm__) && defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 8 && defined(__ARM_PCS_VFP)
+// Other 32-bit ARM builds only get it where GCC can enable it per function
+#include <arm_neon.h>
+#define CRYO_BLIT_NEON
+#define CRYO_BLIT_NEON_OPTIONAL
+#define CRYO_TARGET_NEON __attribute__((target("fpu=neon")))
+#endif
+
+#if defined(CRYO_BLIT_NEON_OPTIONAL) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+namespace Cryo {
+
+void expandNibblesScalar(const byte *src, byte *dst, uint32 pixelCount, byte offset) {
+	for (uint32 i = 0; i < pixelCount / 2; i++) {
+		byte pixel = src[i];
+		dst[0] = (pixel & 0xf) + offset;
+		dst[1] = (pixel >> 4) + offset;
+		dst += 2;
+	}
+}
+
+// Each byte is expanded with a table lookup which yields both pixels at once
+static void expandNibblesTable(const byte *src, byte *dst, uint32 pixelCount, byte offset) {
+	static byte tableOffset = 0;
+	static uint16 table[256];
+	static bool tableReady = false;
+
+	if (!tableReady || tableOffset != offset) {
+		for (uint i = 0; i < 256; i++) {
+			byte pixels[2];
+			pixels[0] = (i & 0xf) + offset;
+			pixels[1] = (i >> 4) + offset;
+			memcpy(&table[i], pixels, 2);
+		}
+		tableOffset = offset;
+		tableReady = true;
+	}
+
+	for (uint32 i = 0; i < pixelCount / 2; i++) {
+		memcpy(dst, &table[src[i]], 2);
+		dst += 2;
+	}
+}
+
+static bool isAlwaysSupported() {
+	return true;
+}
+
+#if defined(CRYO_BLIT_SSE2)
+
+CRYO_TARGET_SSE2
+static void expandNibblesSSE2(const byte *src, byte *dst, uint32 pixelCount, byte offset) {
+	const __m128i lowMask = _mm_set1_epi8(0x0f);
+	const __m128i offsets = _mm_set1_epi8((char)offset);
+	uint32 count = pixelCount / 2;
+	uint32 i = 0;
+
+	// 16 source bytes give 32 pixels
+	for (; i + 16 <= count; i += 16) {
+		__m128i packed = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i low = _mm_add_epi8(_mm_and_si128(packed, lowMask), offsets);
+		__m128i high = _mm_add_epi8(_mm_and_si128(_mm_srli_epi16(packed, 4), lowMask), offsets);
+		_mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(low, high));
+		_mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(low, high));
+	}
+
+	expandNibblesScalar(src + i, dst + i * 2, (count - i) * 2, offset);
+}
+
+static bool hasSSE2() {
+#if defined(__x86_64__) || defined(_M_X64)
+	// SSE2 is part of x86-64
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif
+
+#if defined(CRYO_BLIT_NEON)
+
+CRYO_TARGET_NEON
+static void expandNibblesNEON(const byte *src, byte *dst, uint32 pixelCount, byte offset) {
+	const uint8x16_t lowMask = vdupq_n_u8(0x0f);
+	const uint8x16_t offsets = vdupq_n_u8(offset);
+	uint32 count = pixelCount / 2;
+	uint32 i = 0;
+
+	// 16 source bytes give 32 pixels, which are interleaved by the store
+	for (; i + 16 <= count; i += 16) {
+		uint8x16_t packed = vld1q_u8(src + i);
+		uint8x16x2_t pixels;
+		pixels.val[0] = vaddq_u8(vandq_u8(packed, lowMask), offsets);
+		pixels.val[1] = vaddq_u8(vshrq_n_u8(packed, 4), offsets);
+		vst2q_u8(dst + i * 2, pixels);
+	}
+
+	expandNibblesScalar(src + i, dst + i * 2, (count - i) * 2, offset);
+}
+
+static bool hasNEON() {
+#if !defined(CRYO_BLIT_NEON_OPTIONAL)
+	return true;
+#elif defined(__linux__)
+	// HWCAP_NEON, which isn't defined by all the C libraries
+	return (getauxval(AT_HWCAP) & (1 << 12)) != 0;
+#else
+	return false;
+#endif
+}
+
+#endif
+
+struct NibbleExpanderInfo {
+	NibbleExpander expander;
+	bool (*isSupported)();
+};
+
+// All the versions that were built, fastest first
+static const NibbleExpanderInfo nibbleExpanderInfos[] = {
+#if defined(CRYO_BLIT_SSE2)
+	{ { "sse2", expandNibblesSSE2 }, hasSSE2 },
+#endif
+#if defined(CRYO_BLIT_NEON)
+	{ { "neon", expandNibblesNEON }, hasNEON },
+#endif
+	{ { "table", expandNibblesTable }, isAlwaysSupported },
+	{ { "scalar", expandNibblesScalar }, isAlwaysSupported }
+};
+
+const NibbleExpander *getNibbleExpanders() {
+	static NibbleExpander expanders[ARRAYSIZE(nibbleExpanderInfos) + 1];
+	static bool checked = false;
+
+	if (!checked) {
+		uint count = 0;
+		for (int i = 0; i < ARRAYSIZE(nibbleExpanderInfos); i++) {
+			if (nibbleExpanderInfos[i].isSupported())
+				expanders[count++] = nibbleExpanderInfos[i].expander;
+		}
+
+		expanders[count].name = 0;
+		expanders[count].expand = 0;
+		checked = true;
+	}
+
+	return expanders;
+}
+
+static void expandNibblesFirstCall(const byte *src, byte *dst, uint32 pixelCount, byte offset);
+
+// Starts out with a function which checks the CPU, and replaces itself with
+// the best version
+static ExpandNibblesProc expandNibblesProc = expandNibblesFirstCall;
+
+static void expandNibblesFirstCall(const byte *src, byte *dst, uint32 pixelCount, byte offset) {
+	expandNibblesProc = getNibbleExpanders()[0].expand;
+	expandNibblesProc(src, dst, pixelCount, offset);
+}
+
+void expandNibbles(const byte *src, byte *dst, uint32 pixelCount, byte offset) {
+	expandNibblesProc(src, dst, pixelCount, offset);
+}
+
+const char *getBlitImplementation() {
+	return getNibbleExpanders()[0].name;
+}
+
+// The blitting kernels are specialized for the properties of a draw call
+// which don't change between pixels, so that their loops don't test them.
+// blitFrame() picks the right one once per call.
+
+typedef void (*FrameBlitter)(Graphics::Surface &surface, const DecodedFrame &frame, int16 x, int16 y,
+		const Common::Rect &dest, bool flipY);
+
+/**
+ * Draws the visible part of a frame using its mask. The frame is at x, y on
+ * the screen, and dest is the part of it which is inside of the clip
+ * rectangle. Vertical mirroring only changes the order of the rows, so it
+ * doesn't need a specialization.
+ */
+template<bool kTransparent, bool kFlipped>
+static void blitFrameMask(Graphics::Surface &surface, const DecodedFrame &frame, int16 x, int16 y,
+		const Common::Rect &dest, bool flipY) {
+	// The source pixel of the top left visible pixel. Mirrored frames are
+	// read backwards from there.
+	int16 srcLeft = kFlipped ? (x + frame.width - 1 - dest.left) : (dest.left - x);
+	int16 srcTop = flipY ? (y + frame.height - 1 - dest.top) : (dest.top - y);
+	int32 srcPitch = flipY ? -(int32)frame.width : (int32)frame.width;
+	uint32 srcOffset = srcTop * frame.width + srcLeft;
+	const byte *src = frame.pixels + srcOffset;
+	const byte *mask = frame.mask + srcOffset;
+	byte *dst = (byte *)surface.getBasePtr(dest.left, dest.top);
+	uint16 width = dest.width();
+
+	for (int16 row = dest.top; row < dest.bottom; row++) {
+		if (!kTransparent && !kFlipped) {
+			memcpy(dst, src, width);
+		} else {
+			for (uint16 col = 0; col < width; col++) {
+				if (!kTransparent || (kFlipped ? mask[-col] : mask[col]))
+					dst[col] = kFlipped ? src[-col] : src[col];
+			}
+		}
+
+		src += srcPitch;
+		mask += srcPitch;
+		dst += surface.pitch;
+	}
+}
+
+/**
+ * Draws the visible part of a frame using its span lists
+ */
+template<bool kFlipped>
+static void blitFrameSpans(Graphics::Surface &surface, const DecodedFrame &frame, int16 x, int16 y,
+		const Common::Rect &dest, bool flipY) {
+	// The visible columns, relative to the frame
+	int16 left = kFlipped ? (x + frame.width - dest.right) : (dest.left - x);
+	int16 right = kFlipped ? (x + frame.width - dest.left) : (dest.right - x);
+
+	for (int16 row = dest.top; row < dest.bottom; row++) {
+		uint16 frameRow = flipY ? (y + frame.height - 1 - row) : (row - y);
+		const byte *src = frame.pixels + frameRow * frame.width;
+		// The pixel of column 0 of the frame, which may be outside of the
+		// screen, so it's only used as an offset
+		byte *dst = (byte *)surface.getBasePtr(0, row);
+		int16 dstOrigin = kFlipped ? (x + frame.width - 1) : x;
+
+		for (uint32 i = frame.rowSpans[frameRow]; i < frame.rowSpans[frameRow + 1]; i++) {
+			int16 start = MAX<int16>(frame.spans[i].start, left);
+			int16 end = MIN<int16>(frame.spans[i].start + frame.spans[i].length, right);
+			if (start >= end)
+				continue;
+
+			if (kFlipped) {
+				byte *spanDst = dst + dstOrigin - start;
+				for (int16 col = 0; col < end - start; col++)
+					spanDst[-col] = src[start + col];
+			} else {
+				memcpy(dst + dstOrigin + start, src + start, end - start);
+			}
+		}
+	}
+}
+
+static inline byte getPackedPixel(const byte *row, int16 col) {
+	return (col & 1) ? (row[col >> 1] >> 4) : (row[col >> 1] & 0xf);
+}
+
+/**
+ * Draws the visible part of a packed 4bpp frame, expanding its pixels on the
+ * fly
+ */
+template<bool kTransparent, bool kFlipped>
+static void blitPackedFrame(Graphics::Surface &surface, const DecodedFrame &frame, int16 x, int16 y,
+		const Common::Rect &dest, bool flipY) {
+	int16 srcLeft = kFlipped ? (x + frame.width - 1 - dest.left) : (dest.left - x);
+	int16 srcTop = flipY ? (y + frame.height - 1 - dest.top) : (dest.top - y);
+	int32 rowSize = frame.width / 2;
+	int32 srcPitch = flipY ? -rowSize : rowSize;
+	const byte *src = frame.pixels + srcTop * rowSize;
+	byte *dst = (byte *)surface.getBasePtr(dest.left, dest.top);
+	uint16 width = dest.width();
+
+	for (int16 row = dest.top; row < dest.bottom; row++) {
+		if (!kTransparent && !kFlipped) {
+			// Whole bytes are expanded together, so the pixels at odd
+			// columns at either end are done separately
+			int16 col = srcLeft;
+			byte *out = dst;
+			uint16 remaining = width;
+
+			if (col & 1) {
+				*out++ = getPackedPixel(src, col++) + frame.palOffset;
+				remaining--;
+			}
+
+			uint16 pairs = remaining & ~1;
+			expandNibbles(src + col / 2, out, pairs, frame.palOffset);
+
+			if (remaining & 1)
+				out[pairs] = getPackedPixel(src, col + pairs) + frame.palOffset;
+		} else {
+			for (uint16 col = 0; col < width; col++) {
+				byte pixel = getPackedPixel(src, kFlipped ? srcLeft - col : srcLeft + col);
+				if (!kTransparent || pixel)
+					dst[col] = pixel + frame.palOffset;
+			}
+		}
+
+		src += srcPitch;
+		dst += surface.pitch;
+	}
+}
+
+static const FrameBlitter frameBlitters[2][2] = {
+	{ blitFrameMask<false, false>, blitFrameMask<false, true> },
+	{ blitFrameMask<true, false>, blitFrameMask<true, true> }
+};
+
+static const FrameBlitter frameSpanBlitters[2] = {
+	blitFrameSpans<false>, blitFrameSpans<true>
+};
+
+static const FrameBlitter packedFrameBlitters[2][2] = {
+	{ blitPackedFrame<false, false>, blitPackedFrame<false, true> },
+	{ blitPackedFrame<true, false>, blitPackedFrame<true, true> }
+};
+
+Common::Rect blitFrame(Graphics::Surface &surface, const Common::Rect &clip, const DecodedFrame &frame,
+		int16 x, int16 y, bool flipX, bool flipY) {
+	Common::Rect dest(x, y, x + frame.width, y + frame.height);
+	dest.clip(clip);
+	dest.clip(surface.w, surface.h);
+	if (dest.isEmpty())
+		return Common::Rect();
+
+	// Opaque frames are copied row by row, which is faster than their spans
+	if (frame.packed)
+		packedFrameBlitters[!frame.opaque][flipX](surface, frame, x, y, dest, flipY);
+	else if (frame.hasSpans() && !frame.opaque)
+		frameSpanBlitters[flipX](surface, frame, x, y, dest, flipY);
+	else
+		frameBlitters[!frame.opaque][flipX](surface, frame, x, y, dest, flipY);
+
+	return dest;
+}
+
+} // End of namespace Cryo
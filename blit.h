@@ -0,0 +1,86 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_BLIT_H
+#define CRYO_BLIT_H
+
+#include "common/rect.h"
+#include "common/scummsys.h"
+
+namespace Graphics {
+struct Surface;
+}
+
+namespace Cryo {
+
+struct DecodedFrame;
+
+/**
+ * Expands 4bpp pixel data to 8bpp, adding offset to every pixel. The low
+ * nibble of each source byte is the first of its two pixels. The fastest
+ * version the CPU supports is picked on the first call.
+ *
+ * @param src                 The packed pixels, pixelCount / 2 bytes
+ * @param dst                 The buffer that receives pixelCount bytes
+ * @param pixelCount          The number of pixels, which must be even
+ * @param offset              The palette offset of the pixels
+ */
+void expandNibbles(const byte *src, byte *dst, uint32 pixelCount, byte offset);
+
+/**
+ * The portable version of expandNibbles(). It's also the reference the
+ * others are checked against.
+ */
+void expandNibblesScalar(const byte *src, byte *dst, uint32 pixelCount, byte offset);
+
+typedef void (*ExpandNibblesProc)(const byte *src, byte *dst, uint32 pixelCount, byte offset);
+
+struct NibbleExpander {
+	const char *name;
+	ExpandNibblesProc expand;
+};
+
+/**
+ * Returns the versions of expandNibbles() which the CPU supports, fastest
+ * first. The list ends with an entry without a name. The portable versions
+ * are always in it, so that the others can be checked and measured against
+ * them.
+ */
+const NibbleExpander *getNibbleExpanders();
+
+/**
+ * Returns the name of the expandNibbles() implementation in use
+ */
+const char *getBlitImplementation();
+
+/**
+ * Draws the opaque pixels of a decoded frame into a surface, optionally
+ * mirrored, clipped to the given rectangle and to the surface.
+ *
+ * @return                    The area of the surface which was drawn to
+ */
+Common::Rect blitFrame(Graphics::Surface &surface, const Common::Rect &clip, const DecodedFrame &frame,
+		int16 x, int16 y, bool flipX = false, bool flipY = false);
+
+} // End of namespace Cryo
+
+#endif
@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/debug.h"
 #include "common/system.h"
 
 #include "audio/audiostream.h"
@@ -27,17 +28,23 @@
 #include "audio/decoders/raw.h"
 #include "audio/mixer.h"
 
+#include "cryo/benchmark.h"
 #include "cryo/console.h"
 #include "cryo/cryo.h"
+#include "cryo/framecache.h"
 #include "cryo/resource.h"
+#include "cryo/screen.h"
 #include "cryo/sentences.h"
 #include "cryo/sprite.h"
+#include "cryo/text.h"
 
 namespace Cryo {
 
 CryoConsole::CryoConsole(CryoEngine *engine) : GUI::Debugger(),
 	_engine(engine) {
 
+	registerCmd("bench",				WRAP_METHOD(CryoConsole, cmdBench));
+	registerCmd("cache",				WRAP_METHOD(CryoConsole, cmdCache));
 	registerCmd("dump",				WRAP_METHOD(CryoConsole, cmdDump));
 	registerCmd("sentences",			WRAP_METHOD(CryoConsole, cmdSentences));
 	registerCmd("sound",				WRAP_METHOD(CryoConsole, cmdSound));
@@ -47,23 +54,101 @@ CryoConsole::CryoConsole(CryoEngine *engine) : GUI::Debugger(),
 CryoConsole::~CryoConsole() {
 }
 
+bool CryoConsole::cmdBench(int argc, const char **argv) {
+	uint iterations = (argc > 1) ? atoi(argv[1]) : 10;
+	if (iterations == 0) {
+		debugPrintf("Measures the speed of the resource and graphics decoders\n");
+		debugPrintf("  Usage: %s [iterations]\n", argv[0]);
+		return true;
+	}
+
+	Common::Array<BenchmarkResult> results;
+	Benchmark benchmark(_engine);
+	benchmark.run(iterations, results);
+
+	// Also print the results to stdout, so that they can be collected by scripts
+	for (uint i = 0; i < results.size(); i++) {
+		Common::String line = results[i].toString();
+		debugPrintf("%s\n", line.c_str());
+		debug("%s", line.c_str());
+	}
+
+	return true;
+}
+
+bool CryoConsole::cmdCache(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResourceManager();
+	FrameCache *frameCache = _engine->getFrameCache();
+	TextCache *textCache = _engine->getTextCache();
+
+	if (argc >= 2 && !strcmp(argv[1], "clear")) {
+		resMan->clearCache();
+		frameCache->clear();
+		textCache->clear();
+	} else if (argc >= 3 && !strcmp(argv[1], "budget")) {
+		resMan->setCacheBudget(atoi(argv[2]) * 1024);
+	} else if (argc >= 3 && !strcmp(argv[1], "frames")) {
+		frameCache->setBudget(atoi(argv[2]) * 1024);
+	} else if (argc >= 3 && !strcmp(argv[1], "packed")) {
+		frameCache->setPackedFrames(!strcmp(argv[2], "on"));
+	} else if (argc >= 3 && !strcmp(argv[1], "text")) {
+		textCache->setBudget(atoi(argv[2]) * 1024);
+	} else if (argc >= 2) {
+		debugPrintf("Shows the resource, sprite frame and text cache statistics, or changes the cache settings\n");
+		debugPrintf("  Usage: %s [clear | budget <size in KB> | frames <size in KB> | packed <on | off> | text <size in KB>]\n", argv[0]);
+		return true;
+	}
+
+	ResourceCacheStats stats = resMan->getCacheStats();
+	debugPrintf("Resource cache: %d entries, %d of %d bytes used\n", stats.entries, stats.size, stats.budget);
+	debugPrintf("Hits: %d, misses: %d, evictions: %d\n", stats.hits, stats.misses, stats.evictions);
+
+	stats = frameCache->getStats();
+	debugPrintf("Frame cache: %d entries, %d of %d bytes used, %s frames\n", stats.entries, stats.size, stats.budget,
+			frameCache->getPackedFrames() ? "4bpp" : "8bpp");
+	debugPrintf("Hits: %d, misses: %d, evictions: %d\n", stats.hits, stats.misses, stats.evictions);
+
+	stats = textCache->getStats();
+	debugPrintf("Text cache: %d entries, %d of %d bytes used\n", stats.entries, stats.size, stats.budget);
+	debugPrintf("Hits: %d, misses: %d, evictions: %d\n", stats.hits, stats.misses, stats.evictions);
+
+	return true;
+}
+
 bool CryoConsole::cmdDump(int argc, const char **argv) {
 	if (argc < 2) {
-		debugPrintf("Decompresses the given HSQ file into a raw uncompressed file\n");
-		debugPrintf("  Usage: %s <file name>\n\n", argv[0]);
+		debugPrintf("Decompresses the given HSQ files into raw uncompressed files\n");
+		debugPrintf("  Usage: %s <file name> [<file name> ...]\n", argv[0]);
+		debugPrintf("  Usage: %s all\n\n", argv[0]);
 		debugPrintf("  Example: %s phrase11.hsq\n", argv[0]);
 		debugPrintf("  The above will uncompress phrase11.hsq into phrase11.hsq.raw\n");
+		debugPrintf("  Example: %s all\n", argv[0]);
+		debugPrintf("  The above will uncompress all of the game's resources\n");
 		return true;
 	}
 
-	Common::String fileName(argv[1]);
-	if (!fileName.contains('.'))
-		fileName += ".hsq";
-
 	ResourceManager *resMan = _engine->getResourceManager();
-	resMan->dumpResource(fileName);
+	Common::StringArray fileNames;
+
+	if (argc == 2 && !strcmp(argv[1], "all")) {
+		resMan->listResources(fileNames);
+	} else {
+		for (int i = 1; i < argc; i++) {
+			Common::String fileName(argv[i]);
+			if (!fileName.contains('.'))
+				fileName += ".hsq";
+			fileNames.push_back(fileName);
+		}
+	}
+
+	if (fileNames.size() == 1) {
+		resMan->dumpResource(fileNames[0]);
+		debugPrintf("%s has been dumped to %s\n", fileNames[0].c_str(), (fileNames[0] + ".raw").c_str());
+	} else {
+		uint dumped = resMan->dumpResources(fileNames);
+		debugPrintf("%d of %d files have been dumped\n", dumped, fileNames.size());
+	}
 
-	debugPrintf("%s has been dumped to %s\n", fileName.c_str(), (fileName + ".raw").c_str());
 	return true;
 }
 
@@ -145,22 +230,23 @@ bool CryoConsole::cmdSprite(int argc, const char **argv) {
 		debugPrintf("Frame count: %d\n", frameCount);
 		for (int i = 0; i < frameCount; i++) {
 			FrameInfo info = s->getFrameInfo(i);
-			debugPrintf("%d: offset %d, comp: %d, size: %dx%d, pal offset: %d\n",
-					i, info.offset, info.isCompressed, info.width, info.height, info.palOffset);
+			debugPrintf("%d: offset %d, comp: %d, flip: %d/%d, size: %dx%d, pal offset: %d\n",
+					i, info.offset, info.isCompressed, info.flipX, info.flipY, info.width, info.height, info.palOffset);
 		}
 	} else {
 		// Draw sprite frame
-		//TODO: if any part of the sprite is outside of the screen, the game crashes (graphics.cpp assert)
-		_engine->_system->fillScreen(0);
+		Screen *screen = _engine->getScreen();
+		screen->clear();
 		uint16 frameNumber = atoi(argv[2]);
-		uint16 x = (argc > 3) ? atoi(argv[3]) : 0;
-		uint16 y = (argc > 4) ? atoi(argv[4]) : 0;
+		int16 x = (argc > 3) ? atoi(argv[3]) : 0;
+		int16 y = (argc > 4) ? atoi(argv[4]) : 0;
 
 		if (frameNumber >= frameCount) {
 			debugPrintf("Invalid frame\n");
 		} else {
 			s->setPalette();
 			s->drawFrame(frameNumber, x, y);
+			screen->update();
 			showConsole = false;
 		}
 	}
@@ -35,6 +35,8 @@ public:
 	virtual ~CryoConsole(void);
 
 private:
+	bool cmdBench(int argc, const char **argv);
+	bool cmdCache(int argc, const char **argv);
 	bool cmdDump(int argc, const char **argv);
 	bool cmdSentences(int argc, const char **argv);
 	bool cmdSprite(int argc, const char **argv);
@@ -34,9 +34,12 @@
 #include "cryo/console.h"
 #include "cryo/cryo.h"
 #include "cryo/font.h"
+#include "cryo/framecache.h"
 #include "cryo/resource.h"
+#include "cryo/screen.h"
 #include "cryo/sentences.h"
 #include "cryo/sprite.h"
+#include "cryo/text.h"
 
 namespace Cryo {
  
@@ -60,7 +63,11 @@ CryoEngine::CryoEngine(OSystem *syst, const ADGameDescription *gameDesc)
 	//OLDSTYLE 
 	//g_eventRec.registerRandomSource(_rnd, "cryo");
 	//NEWSTYLE
+	_console = 0;
 	_resMan = 0;
+	_frameCache = 0;
+	_screen = 0;
+	_textCache = 0;
 	_rnd = new Common::RandomSource("cryo_randomseed");
 	//debug("CryoEngine::CryoEngine");
 }
@@ -70,6 +77,10 @@ CryoEngine::~CryoEngine() {
 	//debug("CryoEngine::~CryoEngine");
  
 	// Remove all of our debug levels here
+	delete _console;
+	delete _frameCache;
+	delete _textCache;
+	delete _screen;
 	delete _resMan;
 	delete _rnd;
 	DebugMan.clearAllDebugChannels();
@@ -77,7 +88,8 @@ CryoEngine::~CryoEngine() {
  
 Common::Error CryoEngine::run() {
 	// Initialize graphics using following:
-	initGraphics(320, 200, false);
+	initGraphics(SCREEN_WIDTH, SCREEN_HEIGHT, false);
+	_screen = new Screen(_system);
  
 	// Create debugger console. It requires GFX to be initialized
 	_console = new CryoConsole(this);
@@ -89,6 +101,22 @@ Common::Error CryoEngine::run() {
 	Common::EventManager *eventMan = _system->getEventManager();
 
 	_resMan = new ResourceManager(isCD());
+	if (ConfMan.hasKey("hsq_streaming_threshold"))
+		_resMan->setStreamingThreshold(ConfMan.getInt("hsq_streaming_threshold"));
+	if (ConfMan.hasKey("resource_cache_size"))
+		_resMan->setCacheBudget(ConfMan.getInt("resource_cache_size") * 1024);
+	if (ConfMan.hasKey("resource_disk_cache") && ConfMan.getBool("resource_disk_cache"))
+		_resMan->enableDiskCache(_targetName + ".cache");
+
+	_frameCache = new FrameCache();
+	if (ConfMan.hasKey("frame_cache_size"))
+		_frameCache->setBudget(ConfMan.getInt("frame_cache_size") * 1024);
+	if (ConfMan.hasKey("frame_cache_packed"))
+		_frameCache->setPackedFrames(ConfMan.getBool("frame_cache_packed"));
+
+	_textCache = new TextCache();
+	if (ConfMan.hasKey("text_cache_size"))
+		_textCache->setBudget(ConfMan.getInt("text_cache_size") * 1024);
 
 	// Show something
 	Sprite *s = new Sprite("intds.hsq", this);
@@ -110,7 +138,7 @@ Common::Error CryoEngine::run() {
 	delete g;*/
 
 	// Update the screen so that its contents can be shown
-	_system->updateScreen();
+	_screen->update();
 
 	// Your main even loop should be (invoked from) here.
 	//debug("CryoEngine::go: Hello, World!\n");
@@ -124,7 +152,12 @@ Common::Error CryoEngine::run() {
 		}
 
 		// TODO: Do something...
-		
+
+		_screen->update();
+
+		// Use the idle time of the frame to load queued resources
+		_resMan->processRequests(5);
+
 		_system->delayMillis(10);
 	}
 
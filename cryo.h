@@ -33,7 +33,10 @@
 namespace Cryo {
  
 class CryoConsole;
+class FrameCache;
+class Screen;
 class ResourceManager;
+class TextCache;
 
 // our engine debug levels
 enum {
@@ -52,11 +55,17 @@ public:
  	virtual bool hasFeature(EngineFeature f) const;
 
  	ResourceManager *getResourceManager() const { return _resMan; }
+	FrameCache *getFrameCache() const { return _frameCache; }
+	Screen *getScreen() const { return _screen; }
+	TextCache *getTextCache() const { return _textCache; }
 	bool isCD();
 
 private:
 	CryoConsole *_console;
  	ResourceManager *_resMan;
+	FrameCache *_frameCache;
+	Screen *_screen;
+	TextCache *_textCache;
 
 	// We need random numbers
 	Common::RandomSource* _rnd;
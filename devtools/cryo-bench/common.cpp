@@ -0,0 +1,585 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Implementations of the ScummVM classes which the stand-in headers declare
+
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "common/debug.h"
+#include "common/file.h"
+#include "common/memstream.h"
+#include "common/str-array.h"
+#include "common/substream.h"
+#include "common/func.h"
+#include "graphics/surface.h"
+
+int gDebugLevel = -1;
+
+static void printMessage(const char *prefix, const char *s, va_list va) {
+	fputs(prefix, stderr);
+	vfprintf(stderr, s, va);
+	fputc('\n', stderr);
+}
+
+void error(const char *s, ...) {
+	va_list va;
+	va_start(va, s);
+	printMessage("ERROR: ", s, va);
+	va_end(va);
+	exit(1);
+}
+
+void warning(const char *s, ...) {
+	va_list va;
+	va_start(va, s);
+	printMessage("WARNING: ", s, va);
+	va_end(va);
+}
+
+void debug(const char *s, ...) {
+	if (gDebugLevel < 0)
+		return;
+
+	va_list va;
+	va_start(va, s);
+	printMessage("", s, va);
+	va_end(va);
+}
+
+void debug(int level, const char *s, ...) {
+	if (level > gDebugLevel)
+		return;
+
+	va_list va;
+	va_start(va, s);
+	printMessage("", s, va);
+	va_end(va);
+}
+
+namespace Common {
+
+// String
+
+bool String::equalsIgnoreCase(const String &x) const {
+	return !scumm_stricmp(c_str(), x.c_str());
+}
+
+bool String::equalsIgnoreCase(const char *x) const {
+	return !scumm_stricmp(c_str(), x);
+}
+
+bool String::hasPrefix(const String &x) const {
+	return _str.compare(0, x.size(), x._str) == 0;
+}
+
+bool String::hasSuffix(const String &x) const {
+	return x.size() <= size() && _str.compare(size() - x.size(), x.size(), x._str) == 0;
+}
+
+static bool matchPattern(const char *str, const char *pat, bool ignoreCase) {
+	for (;;) {
+		if (*pat == '*') {
+			// Try all the lengths for the wildcard
+			pat++;
+			do {
+				if (matchPattern(str, pat, ignoreCase))
+					return true;
+			} while (*str++);
+			return false;
+		}
+
+		if (!*pat)
+			return !*str;
+		if (!*str)
+			return false;
+
+		bool same = ignoreCase ? (tolower((byte)*str) == tolower((byte)*pat)) : (*str == *pat);
+		if (*pat != '?' && !same)
+			return false;
+
+		str++;
+		pat++;
+	}
+}
+
+bool String::matchString(const String &pattern, bool ignoreCase) const {
+	return matchPattern(c_str(), pattern.c_str(), ignoreCase);
+}
+
+void String::toLowercase() {
+	for (uint i = 0; i < _str.size(); i++)
+		_str[i] = tolower((byte)_str[i]);
+}
+
+void String::toUppercase() {
+	for (uint i = 0; i < _str.size(); i++)
+		_str[i] = toupper((byte)_str[i]);
+}
+
+String String::format(const char *fmt, ...) {
+	va_list va;
+	va_start(va, fmt);
+	int len = vsnprintf(NULL, 0, fmt, va);
+	va_end(va);
+
+	String output;
+	output._str.resize(len + 1);
+
+	va_start(va, fmt);
+	vsnprintf(&output._str[0], len + 1, fmt, va);
+	va_end(va);
+
+	output._str.resize(len);
+	return output;
+}
+
+String operator+(const String &x, const String &y) {
+	String temp(x);
+	temp += y;
+	return temp;
+}
+
+String operator+(const String &x, const char *y) {
+	String temp(x);
+	temp += y;
+	return temp;
+}
+
+String operator+(const char *x, const String &y) {
+	String temp(x);
+	temp += y;
+	return temp;
+}
+
+String operator+(const String &x, char y) {
+	String temp(x);
+	temp += y;
+	return temp;
+}
+
+int scumm_stricmp(const char *s1, const char *s2) {
+	byte l1, l2;
+	do {
+		l1 = tolower(*(const byte *)s1++);
+		l2 = tolower(*(const byte *)s2++);
+	} while (l1 == l2 && l1 != 0);
+	return l1 - l2;
+}
+
+// Hashing, the same as ScummVM's
+
+uint hashit(const char *p) {
+	uint hash = 0;
+	byte c;
+	while ((c = *p++))
+		hash = (hash * 31 + c);
+	return hash;
+}
+
+uint hashit_lower(const char *p) {
+	uint hash = 0;
+	byte c;
+	while ((c = *p++))
+		hash = (hash * 31 + tolower(c));
+	return hash;
+}
+
+// Streams
+
+MemoryReadStream::~MemoryReadStream() {
+	if (_disposeMemory)
+		free(const_cast<byte *>(_ptrOrig));
+}
+
+uint32 MemoryReadStream::read(void *dataPtr, uint32 dataSize) {
+	if (dataSize > _size - _pos) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+	memcpy(dataPtr, _ptr, dataSize);
+
+	_ptr += dataSize;
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+bool MemoryReadStream::seek(int32 offs, int whence) {
+	switch (whence) {
+	case SEEK_END:
+		offs = size() + offs;
+		break;
+	case SEEK_CUR:
+		offs = _pos + offs;
+		break;
+	}
+
+	if (offs < 0 || offs > size())
+		return false;
+
+	_pos = offs;
+	_ptr = _ptrOrig + offs;
+	_eos = false;
+	return true;
+}
+
+SafeSeekableSubReadStream::SafeSeekableSubReadStream(SeekableReadStream *parentStream, uint32 begin, uint32 end,
+		DisposeAfterUse::Flag disposeParentStream)
+	: _parentStream(parentStream), _disposeParentStream(disposeParentStream), _begin(begin), _end(end), _pos(begin), _eos(false) {
+	assert(_begin <= _end);
+}
+
+SafeSeekableSubReadStream::~SafeSeekableSubReadStream() {
+	if (_disposeParentStream)
+		delete _parentStream;
+}
+
+uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
+	if (dataSize > _end - _pos) {
+		dataSize = _end - _pos;
+		_eos = true;
+	}
+
+	if (!_parentStream->seek(_pos))
+		return 0;
+
+	dataSize = _parentStream->read(dataPtr, dataSize);
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+bool SafeSeekableSubReadStream::seek(int32 offset, int whence) {
+	switch (whence) {
+	case SEEK_END:
+		offset = size() + offset;
+		break;
+	case SEEK_CUR:
+		offset = pos() + offset;
+		break;
+	}
+
+	if (offset < 0 || offset > size())
+		return false;
+
+	_pos = _begin + offset;
+	_eos = false;
+	return true;
+}
+
+/**
+ * A read stream on a file of the host file system
+ */
+class StdioStream : public SeekableReadStream {
+public:
+	StdioStream(FILE *handle) : _handle(handle) {}
+	~StdioStream() { fclose(_handle); }
+
+	uint32 read(void *dataPtr, uint32 dataSize) { return fread(dataPtr, 1, dataSize, _handle); }
+	bool eos() const { return feof(_handle) != 0; }
+	void clearErr() { clearerr(_handle); }
+	bool err() const { return ferror(_handle) != 0; }
+
+	int32 pos() const { return ftell(_handle); }
+
+	int32 size() const {
+		int32 oldPos = ftell(_handle);
+		fseek(_handle, 0, SEEK_END);
+		int32 length = ftell(_handle);
+		fseek(_handle, oldPos, SEEK_SET);
+		return length;
+	}
+
+	bool seek(int32 offs, int whence) {
+		clearerr(_handle);
+		return fseek(_handle, offs, whence) == 0;
+	}
+
+private:
+	FILE *_handle;
+};
+
+// Archives
+
+SeekableReadStream *GenericArchiveMember::createReadStream() const {
+	return _parent->createReadStreamForMember(_name);
+}
+
+int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
+	ArchiveMemberList allNames;
+	listMembers(allNames);
+
+	int matches = 0;
+	for (ArchiveMemberList::const_iterator it = allNames.begin(); it != allNames.end(); ++it) {
+		if ((*it)->getName().matchString(pattern, true)) {
+			list.push_back(*it);
+			matches++;
+		}
+	}
+
+	return matches;
+}
+
+/**
+ * The files of a directory, which are looked up regardless of their case
+ */
+class DirectoryArchive : public Archive {
+public:
+	DirectoryArchive(const String &path) : _path(path) {
+		DIR *dir = opendir(path.c_str());
+		if (!dir)
+			return;
+
+		while (struct dirent *entry = readdir(dir)) {
+			String name(entry->d_name);
+			struct stat st;
+			if (!stat((_path + "/" + name).c_str(), &st) && S_ISREG(st.st_mode))
+				_fileNames.push_back(name);
+		}
+
+		closedir(dir);
+	}
+
+	bool hasFile(const String &name) const {
+		return !findFile(name).empty();
+	}
+
+	int listMembers(ArchiveMemberList &list) const {
+		for (uint i = 0; i < _fileNames.size(); i++)
+			list.push_back(ArchiveMemberPtr(new GenericArchiveMember(_fileNames[i], this)));
+		return _fileNames.size();
+	}
+
+	const ArchiveMemberPtr getMember(const String &name) const {
+		String fileName = findFile(name);
+		if (fileName.empty())
+			return ArchiveMemberPtr();
+		return ArchiveMemberPtr(new GenericArchiveMember(fileName, this));
+	}
+
+	SeekableReadStream *createReadStreamForMember(const String &name) const {
+		String fileName = findFile(name);
+		if (fileName.empty())
+			return 0;
+
+		FILE *handle = fopen((_path + "/" + fileName).c_str(), "rb");
+		return handle ? new StdioStream(handle) : 0;
+	}
+
+private:
+	String findFile(const String &name) const {
+		for (uint i = 0; i < _fileNames.size(); i++) {
+			if (_fileNames[i].equalsIgnoreCase(name))
+				return _fileNames[i];
+		}
+		return String();
+	}
+
+	String _path;
+	StringArray _fileNames;
+};
+
+SearchSet::~SearchSet() {
+	for (List<Node>::iterator it = _list.begin(); it != _list.end(); ++it) {
+		if (it->autoFree)
+			delete it->arch;
+	}
+}
+
+void SearchSet::add(const String &name, Archive *arch, int priority, bool autoFree) {
+	Node node;
+	node.name = name;
+	node.arch = arch;
+	node.autoFree = autoFree;
+	_list.push_back(node);
+}
+
+void SearchSet::addDirectory(const String &name, const String &directory, int priority) {
+	add(name, new DirectoryArchive(directory), priority);
+}
+
+bool SearchSet::hasFile(const String &name) const {
+	for (List<Node>::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		if (it->arch->hasFile(name))
+			return true;
+	}
+	return false;
+}
+
+int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
+	int matches = 0;
+	for (List<Node>::const_iterator it = _list.begin(); it != _list.end(); ++it)
+		matches += it->arch->listMatchingMembers(list, pattern);
+	return matches;
+}
+
+int SearchSet::listMembers(ArchiveMemberList &list) const {
+	int matches = 0;
+	for (List<Node>::const_iterator it = _list.begin(); it != _list.end(); ++it)
+		matches += it->arch->listMembers(list);
+	return matches;
+}
+
+const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
+	for (List<Node>::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		if (it->arch->hasFile(name))
+			return it->arch->getMember(name);
+	}
+	return ArchiveMemberPtr();
+}
+
+SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) const {
+	for (List<Node>::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		SeekableReadStream *stream = it->arch->createReadStreamForMember(name);
+		if (stream)
+			return stream;
+	}
+	return 0;
+}
+
+SearchManager &SearchManager::instance() {
+	static SearchManager searchManager;
+	return searchManager;
+}
+
+// Files
+
+File::File() : _handle(0) {
+}
+
+File::~File() {
+	close();
+}
+
+bool File::exists(const String &filename) {
+	return SearchMan.hasFile(filename);
+}
+
+bool File::open(const String &filename) {
+	close();
+	_handle = SearchMan.createReadStreamForMember(filename);
+	return _handle != 0;
+}
+
+void File::close() {
+	delete _handle;
+	_handle = 0;
+}
+
+uint32 File::read(void *dataPtr, uint32 dataSize) {
+	assert(_handle);
+	return _handle->read(dataPtr, dataSize);
+}
+
+bool File::eos() const {
+	assert(_handle);
+	return _handle->eos();
+}
+
+void File::clearErr() {
+	assert(_handle);
+	_handle->clearErr();
+}
+
+int32 File::pos() const {
+	assert(_handle);
+	return _handle->pos();
+}
+
+int32 File::size() const {
+	assert(_handle);
+	return _handle->size();
+}
+
+bool File::seek(int32 offs, int whence) {
+	assert(_handle);
+	return _handle->seek(offs, whence);
+}
+
+DumpFile::DumpFile() : _handle(0) {
+}
+
+DumpFile::~DumpFile() {
+	close();
+}
+
+bool DumpFile::open(const String &filename) {
+	close();
+	_handle = fopen(filename.c_str(), "wb");
+	return _handle != 0;
+}
+
+void DumpFile::close() {
+	if (_handle)
+		fclose(_handle);
+	_handle = 0;
+}
+
+uint32 DumpFile::write(const void *dataPtr, uint32 dataSize) {
+	assert(_handle);
+	return fwrite(dataPtr, 1, dataSize, _handle);
+}
+
+bool DumpFile::flush() {
+	assert(_handle);
+	return fflush(_handle) == 0;
+}
+
+int32 DumpFile::pos() const {
+	assert(_handle);
+	return ftell(_handle);
+}
+
+} // End of namespace Common
+
+namespace Graphics {
+
+void Surface::create(uint16 width, uint16 height, const PixelFormat &f) {
+	free();
+
+	w = width;
+	h = height;
+	format = f;
+	pitch = w * format.bytesPerPixel;
+
+	if (width && height)
+		pixels = calloc(width * height, format.bytesPerPixel);
+}
+
+void Surface::free() {
+	::free(pixels);
+	pixels = 0;
+	w = h = pitch = 0;
+	format = PixelFormat();
+}
+
+void Surface::init(uint16 width, uint16 height, uint16 newPitch, void *newPixels, const PixelFormat &f) {
+	w = width;
+	h = height;
+	pitch = newPitch;
+	pixels = newPixels;
+	format = f;
+}
+
+} // End of namespace Graphics
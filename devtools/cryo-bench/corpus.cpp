@@ -0,0 +1,573 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/memstream.h"
+#include "common/util.h"
+
+#include "corpus.h"
+
+// HSQ back references reach up to 8192 bytes behind, and copy up to 257
+// bytes. The short form reaches 256 bytes behind, and copies 2 to 5 bytes.
+#define HSQ_WINDOW_SIZE 8192
+#define HSQ_MAX_MATCH 257
+#define HSQ_SHORT_DISTANCE 256
+#define HSQ_SHORT_MAX_MATCH 5
+
+// How many earlier positions with the same hash the packer tries
+#define HSQ_MAX_CHAIN 64
+
+#define HSQ_HASH_BITS 12
+
+/**
+ * Writes the bits and bytes of HSQ data in the order the decoders read them.
+ * The decoders read a 16-bit word of bits when they need a bit and have none
+ * left, so the place of a word is set aside when its first bit is written.
+ */
+class HsqWriter {
+public:
+	HsqWriter(Common::Array<byte> &output) : _output(output), _queuePos(-1), _queue(0), _bitCount(16) {}
+
+	void putBit(byte bit) {
+		if (_bitCount == 16) {
+			flushQueue();
+			_queuePos = _output.size();
+			_output.push_back(0);
+			_output.push_back(0);
+			_bitCount = 0;
+		}
+
+		_queue |= bit << _bitCount;
+		_bitCount++;
+	}
+
+	void putByte(byte value) {
+		_output.push_back(value);
+	}
+
+	void putLiteral(byte value) {
+		putBit(1);
+		putByte(value);
+	}
+
+	void putMatch(uint16 length, uint16 distance) {
+		putBit(0);
+
+		if (distance <= HSQ_SHORT_DISTANCE && length <= HSQ_SHORT_MAX_MATCH) {
+			putBit(0);
+			putBit((length - 2) >> 1);
+			putBit((length - 2) & 1);
+			putByte(HSQ_SHORT_DISTANCE - distance);
+			return;
+		}
+
+		uint16 value = HSQ_WINDOW_SIZE - distance;
+		uint16 count = (length <= 9) ? length - 2 : 0;
+
+		putBit(1);
+		putByte((value << 3) | count);
+		putByte(value >> 5);
+		if (!count)
+			putByte(length - 2);
+	}
+
+	void finish() {
+		// The end marker is a long back reference with an extra count of 0
+		putBit(0);
+		putBit(1);
+		putByte(0);
+		putByte(0);
+		putByte(0);
+		flushQueue();
+	}
+
+private:
+	void flushQueue() {
+		if (_queuePos >= 0) {
+			_output[_queuePos] = _queue & 0xFF;
+			_output[_queuePos + 1] = _queue >> 8;
+		}
+		_queue = 0;
+	}
+
+	Common::Array<byte> &_output;
+	int32 _queuePos;	// where the current word of bits goes, -1 before the first one
+	uint16 _queue;
+	uint _bitCount;
+};
+
+static inline uint hashBytes(const byte *data) {
+	return ((data[0] << 8) ^ (data[1] << 4) ^ data[2]) & ((1 << HSQ_HASH_BITS) - 1);
+}
+
+void packHsq(const byte *data, uint32 size, Common::Array<byte> &packed) {
+	if (size > 0xFFFF)
+		error("packHsq: %d bytes don't fit in an HSQ file", size);
+
+	packed.clear();
+	for (uint i = 0; i < 6; i++)
+		packed.push_back(0);
+
+	// The positions with the same hash are chained, most recent first
+	Common::Array<int32> head(1 << HSQ_HASH_BITS, -1);
+	Common::Array<int32> chain(size, -1);
+	HsqWriter writer(packed);
+	uint32 pos = 0;
+
+	while (pos < size) {
+		uint16 bestLength = 0;
+		uint16 bestDistance = 0;
+
+		if (pos + 3 <= size) {
+			uint32 maxLength = MIN<uint32>(HSQ_MAX_MATCH, size - pos);
+			int32 candidate = head[hashBytes(data + pos)];
+
+			for (uint tries = 0; candidate >= 0 && pos - candidate <= HSQ_WINDOW_SIZE && tries < HSQ_MAX_CHAIN; tries++) {
+				uint32 length = 0;
+				while (length < maxLength && data[candidate + length] == data[pos + length])
+					length++;
+
+				if (length > bestLength) {
+					bestLength = length;
+					bestDistance = pos - candidate;
+					if (length == maxLength)
+						break;
+				}
+
+				candidate = chain[candidate];
+			}
+		}
+
+		// Two byte matches only pay off in the short form
+		if (bestLength == 2 && bestDistance > HSQ_SHORT_DISTANCE)
+			bestLength = 0;
+		if (bestLength == 0 && pos >= 1 && pos + 2 <= size) {
+			uint32 distance = MIN<uint32>(pos, HSQ_SHORT_DISTANCE);
+			for (uint32 d = 1; d <= distance; d++) {
+				if (data[pos - d] == data[pos] && data[pos - d + 1] == data[pos + 1]) {
+					bestLength = 2;
+					bestDistance = d;
+					break;
+				}
+			}
+		}
+
+		uint32 length = (bestLength >= 2) ? bestLength : 1;
+		if (length >= 2)
+			writer.putMatch(length, bestDistance);
+		else
+			writer.putLiteral(data[pos]);
+
+		for (uint32 i = 0; i < length; i++, pos++) {
+			if (pos + 3 <= size) {
+				uint hash = hashBytes(data + pos);
+				chain[pos] = head[hash];
+				head[hash] = pos;
+			}
+		}
+	}
+
+	writer.finish();
+
+	if (packed.size() > 0xFFFF)
+		error("packHsq: The packed data is too large, %d bytes", packed.size());
+
+	// The bytes of the header add up to 171 with the salt byte
+	WRITE_LE_UINT16(&packed[0], size);
+	packed[2] = 0;
+	WRITE_LE_UINT16(&packed[3], packed.size());
+	byte sum = 0;
+	for (uint i = 0; i < 5; i++)
+		sum += packed[i];
+	packed[5] = 171 - sum;
+}
+
+SpriteBuilder::SpriteBuilder() {
+}
+
+void SpriteBuilder::addPalette(byte start, byte count, const byte *colors) {
+	_palette.push_back(start);
+	_palette.push_back(count);
+	for (uint i = 0; i < count * 3u; i++)
+		_palette.push_back(colors[i] & 0x3F);
+}
+
+/**
+ * Packs a byte sequence with the RLE scheme of the sprites: a negative count
+ * n is followed by a byte which is repeated -n + 1 times, a positive one by
+ * n + 1 bytes
+ */
+static void packRle(const Common::Array<byte> &data, Common::Array<byte> &output) {
+	uint32 pos = 0;
+
+	while (pos < data.size()) {
+		uint32 repeat = 1;
+		while (pos + repeat < data.size() && repeat < 129 && data[pos + repeat] == data[pos])
+			repeat++;
+
+		if (repeat >= 2) {
+			output.push_back((byte)(int8)(1 - (int)repeat));
+			output.push_back(data[pos]);
+			pos += repeat;
+			continue;
+		}
+
+		// Collect bytes up to the next repetition
+		uint32 end = pos + 1;
+		while (end < data.size() && end - pos < 128 && !(end + 1 < data.size() && data[end] == data[end + 1]))
+			end++;
+
+		output.push_back(end - pos - 1);
+		for (uint32 i = pos; i < end; i++)
+			output.push_back(data[i]);
+		pos = end;
+	}
+}
+
+void SpriteBuilder::addFrame(uint16 width, byte height, int8 palOffset, bool rle, bool flipX, bool flipY,
+		const byte *pixels) {
+	assert(width % 4 == 0 && width <= 0x1FF);
+
+	Common::Array<byte> frame;
+	uint16 flags = width | (rle ? 0x8000 : 0) | (flipX ? 0x4000 : 0) | (flipY ? 0x2000 : 0);
+	frame.push_back(flags & 0xFF);
+	frame.push_back(flags >> 8);
+	frame.push_back(height);
+	frame.push_back((byte)palOffset);
+
+	// The low nibble of a byte is the first of its pixels
+	Common::Array<byte> nibbles;
+	for (uint32 i = 0; i < width * height; i += 2)
+		nibbles.push_back((pixels[i] & 0xF) | ((pixels[i + 1] & 0xF) << 4));
+
+	if (rle) {
+		packRle(nibbles, frame);
+	} else {
+		for (uint32 i = 0; i < nibbles.size(); i++)
+			frame.push_back(nibbles[i]);
+	}
+
+	_frames.push_back(frame);
+}
+
+void SpriteBuilder::build(Common::Array<byte> &data) const {
+	data.clear();
+
+	// The palette chunk starts with its own size, and ends with FF FF
+	uint16 chunkSize = 2 + _palette.size() + 2;
+	data.push_back(chunkSize & 0xFF);
+	data.push_back(chunkSize >> 8);
+	for (uint i = 0; i < _palette.size(); i++)
+		data.push_back(_palette[i]);
+	data.push_back(0xFF);
+	data.push_back(0xFF);
+
+	// The frame table starts with its size, followed by the offsets of the
+	// frames from its start
+	uint32 tableStart = data.size();
+	uint32 offset = 2 + _frames.size() * 2;
+	data.push_back(offset & 0xFF);
+	data.push_back(offset >> 8);
+
+	for (uint i = 0; i < _frames.size(); i++) {
+		if (offset > 0xFFFF)
+			error("SpriteBuilder: Too much frame data");
+		data.push_back(offset & 0xFF);
+		data.push_back(offset >> 8);
+		offset += _frames[i].size();
+	}
+
+	assert(data.size() == tableStart + 2 + _frames.size() * 2);
+	for (uint i = 0; i < _frames.size(); i++) {
+		for (uint j = 0; j < _frames[i].size(); j++)
+			data.push_back(_frames[i][j]);
+	}
+}
+
+CorpusArchive::CorpusArchive() : _rnd("cryo_bench_corpus"), _packedSize(0) {
+	generateBackground();
+	generateSprites();
+	generateSpriteFont();
+	generateFixedFont();
+	generatePhrases("phrase11.hsq", 400);
+	generatePhrases("phrase12.hsq", 400);
+	generatePhrases("phrase21.hsq", 250);
+	generateData();
+}
+
+void CorpusArchive::addMember(const Common::String &name, const Common::Array<byte> &data) {
+	Member member;
+	member.name = name;
+	member.unpacked = data;
+	packHsq(data.begin(), data.size(), member.packed);
+
+	_packedSize += member.packed.size();
+	_members.push_back(member);
+	_names.push_back(name);
+}
+
+const CorpusArchive::Member *CorpusArchive::findMember(const Common::String &name) const {
+	for (uint i = 0; i < _members.size(); i++) {
+		if (_members[i].name.equalsIgnoreCase(name))
+			return &_members[i];
+	}
+	return 0;
+}
+
+bool CorpusArchive::hasFile(const Common::String &name) const {
+	return findMember(name) != 0;
+}
+
+int CorpusArchive::listMembers(Common::ArchiveMemberList &list) const {
+	for (uint i = 0; i < _members.size(); i++)
+		list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_members[i].name, this)));
+	return _members.size();
+}
+
+const Common::ArchiveMemberPtr CorpusArchive::getMember(const Common::String &name) const {
+	const Member *member = findMember(name);
+	if (!member)
+		return Common::ArchiveMemberPtr();
+	return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(member->name, this));
+}
+
+Common::SeekableReadStream *CorpusArchive::createReadStreamForMember(const Common::String &name) const {
+	const Member *member = findMember(name);
+	if (!member)
+		return 0;
+	return new Common::MemoryReadStream(member->packed.begin(), member->packed.size());
+}
+
+const Common::Array<byte> &CorpusArchive::getUnpacked(const Common::String &name) const {
+	const Member *member = findMember(name);
+	assert(member);
+	return member->unpacked;
+}
+
+// The background is a full screen frame stored unpacked, with smooth areas
+// and some noise, like the scanned backgrounds of the game
+void CorpusArchive::generateBackground() {
+	SpriteBuilder sprite;
+	byte colors[16 * 3];
+
+	for (uint i = 0; i < 16; i++) {
+		colors[i * 3] = i * 4;
+		colors[i * 3 + 1] = i * 3;
+		colors[i * 3 + 2] = 63 - i * 4;
+	}
+	sprite.addPalette(0, 16, colors);
+	sprite.addPalette(0, 1, colors);	// an empty entry, which is skipped
+	sprite.addPalette(16, 16, colors);
+
+	Common::Array<byte> pixels(320 * 200);
+	for (uint y = 0; y < 200; y++) {
+		for (uint x = 0; x < 320; x++) {
+			uint value = (x / 20 + y / 25) & 0xF;
+			if (_rnd.getRandomNumber(7) == 0)
+				value = _rnd.getRandomNumber(15);
+			pixels[y * 320 + x] = value;
+		}
+	}
+	sprite.addFrame(320, 200, 0, false, false, false, pixels.begin());
+
+	// A smaller opaque frame with a palette offset
+	for (uint i = 0; i < 64 * 48; i++)
+		pixels[i] = _rnd.getRandomNumber(15);
+	sprite.addFrame(64, 48, 16, false, false, false, pixels.begin());
+
+	Common::Array<byte> data;
+	sprite.build(data);
+	addMember("intds.hsq", data);
+}
+
+/**
+ * Draws a filled ellipse of a color into a frame, which gives the shapes
+ * transparent corners
+ */
+static void drawBlob(byte *pixels, uint16 width, uint16 height, uint16 cx, uint16 cy, uint16 rx, uint16 ry, byte color) {
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int dx = x - cx;
+			int dy = y - cy;
+			if (dx * dx * ry * ry + dy * dy * rx * rx <= rx * rx * ry * ry)
+				pixels[y * width + x] = color;
+		}
+	}
+}
+
+// Character and object sprites are RLE packed, with transparent areas and
+// runs of the same color
+void CorpusArchive::generateSprites() {
+	SpriteBuilder sprite;
+	byte colors[32 * 3];
+
+	for (uint i = 0; i < 32 * 3; i++)
+		colors[i] = _rnd.getRandomNumber(63);
+	sprite.addPalette(32, 32, colors);
+
+	for (uint f = 0; f < 32; f++) {
+		uint16 width = _rnd.getRandomNumberRng(4, 28) * 4;
+		byte height = _rnd.getRandomNumberRng(8, 96);
+		Common::Array<byte> pixels(width * height, 0);
+
+		for (uint b = 0; b < 6; b++) {
+			drawBlob(pixels.begin(), width, height,
+					_rnd.getRandomNumber(width - 1), _rnd.getRandomNumber(height - 1),
+					_rnd.getRandomNumberRng(2, width / 2), _rnd.getRandomNumberRng(2, height / 2),
+					_rnd.getRandomNumberRng(1, 15));
+		}
+
+		// Some texture, which breaks up the runs
+		for (uint i = 0; i < pixels.size(); i++) {
+			if (pixels[i] && _rnd.getRandomNumber(5) == 0)
+				pixels[i] = _rnd.getRandomNumberRng(1, 15);
+		}
+
+		sprite.addFrame(width, height, (f % 3) * 16, true, f % 4 == 1, f % 8 == 3, pixels.begin());
+	}
+
+	Common::Array<byte> data;
+	sprite.build(data);
+	addMember("mirror.hsq", data);
+}
+
+// The sprite font has a frame per character from '!' up
+void CorpusArchive::generateSpriteFont() {
+	SpriteBuilder sprite;
+	byte colors[4 * 3] = { 0, 0, 0, 63, 63, 63, 40, 40, 40, 20, 20, 20 };
+	sprite.addPalette(240, 4, colors);
+
+	for (uint c = '!'; c <= 'z'; c++) {
+		uint16 width = (c == 'M' || c == 'W' || c == 'm' || c == 'w') ? 12 : 8;
+		byte height = 12;
+		Common::Array<byte> pixels(width * height, 0);
+
+		for (uint y = 1; y + 1 < height; y++) {
+			for (uint x = 1; x + 1 < width; x++) {
+				if (_rnd.getRandomNumber(9) < 4)
+					pixels[y * width + x] = _rnd.getRandomNumberRng(1, 3);
+			}
+		}
+
+		sprite.addFrame(width, height, 0, true, false, false, pixels.begin());
+	}
+
+	Common::Array<byte> data;
+	sprite.build(data);
+	addMember("generic.hsq", data);
+}
+
+// The fixed font has the widths of all the characters, followed by their
+// rows, 9 per character
+void CorpusArchive::generateFixedFont() {
+	Common::Array<byte> data(256 + 256 * 9, 0);
+
+	for (uint c = 0; c < 256; c++) {
+		byte width = (c < ' ') ? 0 : ((c == ' ') ? 4 : _rnd.getRandomNumberRng(4, 8));
+		data[c] = width;
+
+		if (c <= ' ')
+			continue;
+
+		// The leftmost column is the top bit, and the last one is left blank
+		byte mask = (0xFF << (9 - width)) & 0xFF;
+		for (uint row = 0; row < 9; row++)
+			data[256 + c * 9 + row] = _rnd.getRandomNumber(255) & mask;
+	}
+
+	addMember("dunechar.hsq", data);
+}
+
+static const char *const corpusWords[] = {
+	"the", "spice", "must", "flow", "Paul", "Jessica", "Duncan", "Gurney", "harvester", "sietch",
+	"Fremen", "Harkonnen", "Arrakis", "desert", "worm", "water", "ornithopter", "palace", "troops",
+	"production", "ecology", "Stilgar", "Liet", "Kynes", "Baron", "Feyd", "Emperor", "of", "and",
+	"to", "we", "will", "need", "more", "is", "in", "a", "north", "south", "storm", 0
+};
+
+// Phrase files start with a table of the offsets of the sentences. The
+// sentences end with FF, and have control bytes the text display skips.
+void CorpusArchive::generatePhrases(const Common::String &name, uint16 count) {
+	uint wordCount = 0;
+	while (corpusWords[wordCount])
+		wordCount++;
+
+	Common::Array<byte> data(count * 2, 0);
+
+	for (uint16 s = 0; s < count; s++) {
+		WRITE_LE_UINT16(&data[s * 2], data.size());
+
+		uint words = _rnd.getRandomNumberRng(3, 24);
+		for (uint w = 0; w < words; w++) {
+			if (w)
+				data.push_back(' ');
+
+			const char *word = corpusWords[_rnd.getRandomNumber(wordCount - 1)];
+			for (const char *p = word; *p; p++)
+				data.push_back(*p);
+
+			if (_rnd.getRandomNumber(9) == 0)
+				data.push_back(0x0D);
+		}
+
+		data.push_back(0x2E);
+		data.push_back(0xFF);
+	}
+
+	addMember(name, data);
+}
+
+// Resources of other kinds, which only go through the HSQ decoders
+void CorpusArchive::generateData() {
+	// Tables of 16-bit values, like the map and the globe data
+	Common::Array<byte> tables;
+	for (uint i = 0; i < 16384; i++) {
+		uint16 value = (i * 37) % 1024 + ((_rnd.getRandomNumber(15) == 0) ? _rnd.getRandomNumber(255) : 0);
+		tables.push_back(value & 0xFF);
+		tables.push_back(value >> 8);
+	}
+	addMember("map.hsq", tables);
+
+	// Long runs with some changes, which gives long back references
+	Common::Array<byte> runs;
+	while (runs.size() < 60000) {
+		byte value = _rnd.getRandomNumber(255);
+		uint length = _rnd.getRandomNumberRng(1, 300);
+		for (uint i = 0; i < length; i++)
+			runs.push_back(value);
+	}
+	addMember("sky.hsq", runs);
+
+	// Noise, which doesn't compress at all
+	Common::Array<byte> noise;
+	for (uint i = 0; i < 20000; i++)
+		noise.push_back(_rnd.getRandomNumber(255));
+	addMember("noise.hsq", noise);
+
+	// Repeated records with short differences, which give short back
+	// references
+	Common::Array<byte> records;
+	for (uint i = 0; i < 3000; i++) {
+		for (uint j = 0; j < 12; j++)
+			records.push_back((j < 4) ? _rnd.getRandomNumber(7) : j * 3);
+	}
+	addMember("dialogue.hsq", records);
+}
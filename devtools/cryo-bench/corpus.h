@@ -0,0 +1,111 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_BENCH_CORPUS_H
+#define CRYO_BENCH_CORPUS_H
+
+#include "common/archive.h"
+#include "common/array.h"
+#include "common/str-array.h"
+#include "common/random.h"
+
+/**
+ * Packs data in the HSQ format of the game, header included. The packer
+ * looks for the longest match at every position, which is good enough for
+ * benchmark data, if not as tight as the original packer.
+ */
+void packHsq(const byte *data, uint32 size, Common::Array<byte> &packed);
+
+/**
+ * Builds a sprite file: a palette chunk followed by a frame table and the
+ * frames, which are RLE packed or stored as they are
+ */
+class SpriteBuilder {
+public:
+	SpriteBuilder();
+
+	/**
+	 * Adds a range of 6-bit VGA colors to the palette chunk
+	 */
+	void addPalette(byte start, byte count, const byte *colors);
+
+	/**
+	 * Adds a frame. Its pixels are 4bpp values, one per byte, and its width
+	 * must be a multiple of 4. Pixels of value 0 are transparent in RLE
+	 * frames.
+	 */
+	void addFrame(uint16 width, byte height, int8 palOffset, bool rle, bool flipX, bool flipY, const byte *pixels);
+
+	void build(Common::Array<byte> &data) const;
+
+private:
+	Common::Array<byte> _palette;
+	Common::Array<Common::Array<byte> > _frames;
+};
+
+/**
+ * The synthetic game data which cryo-bench runs on when no game directory is
+ * given. It has the members the benchmarks look for, with the floppy names,
+ * and mimics the kinds of data of the game.
+ */
+class CorpusArchive : public Common::Archive {
+public:
+	CorpusArchive();
+
+	bool hasFile(const Common::String &name) const;
+	int listMembers(Common::ArchiveMemberList &list) const;
+	const Common::ArchiveMemberPtr getMember(const Common::String &name) const;
+	Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const;
+
+	/**
+	 * Returns the data of a member before it was packed, which the checks
+	 * compare the decoders against
+	 */
+	const Common::Array<byte> &getUnpacked(const Common::String &name) const;
+
+	const Common::StringArray &getMemberNames() const { return _names; }
+	uint32 getPackedSize() const { return _packedSize; }
+
+private:
+	struct Member {
+		Common::String name;
+		Common::Array<byte> unpacked;
+		Common::Array<byte> packed;
+	};
+
+	void addMember(const Common::String &name, const Common::Array<byte> &data);
+	const Member *findMember(const Common::String &name) const;
+
+	void generateBackground();
+	void generateSprites();
+	void generateSpriteFont();
+	void generateFixedFont();
+	void generatePhrases(const Common::String &name, uint16 count);
+	void generateData();
+
+	Common::RandomSource _rnd;
+	Common::StringArray _names;
+	Common::Array<Member> _members;
+	uint32 _packedSize;
+};
+
+#endif
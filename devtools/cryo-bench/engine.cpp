@@ -0,0 +1,63 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// cryo-bench doesn't link cryo.cpp, which needs the rest of ScummVM. The
+// engine is set up here with the subsystems which the benchmarks use.
+
+#include "cryo/cryo.h"
+#include "cryo/framecache.h"
+#include "cryo/resource.h"
+#include "cryo/screen.h"
+#include "cryo/text.h"
+
+namespace Cryo {
+
+CryoEngine::CryoEngine(OSystem *syst, const ADGameDescription *gameDesc)
+	: Engine(syst), _gameDescription(gameDesc) {
+	_console = 0;
+	_rnd = 0;
+	_screen = new Screen(_system);
+	_resMan = new ResourceManager(isCD());
+	_frameCache = new FrameCache();
+	_textCache = new TextCache();
+}
+
+CryoEngine::~CryoEngine() {
+	delete _frameCache;
+	delete _textCache;
+	delete _screen;
+	delete _resMan;
+}
+
+Common::Error CryoEngine::run() {
+	return Common::kNoError;
+}
+
+bool CryoEngine::hasFeature(EngineFeature f) const {
+	return false;
+}
+
+bool CryoEngine::isCD() {
+	return _gameDescription->flags & ADGF_CD;
+}
+
+} // End of namespace Cryo
@@ -0,0 +1,106 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ARCHIVE_H
+#define COMMON_ARCHIVE_H
+
+#include "common/list.h"
+#include "common/ptr.h"
+#include "common/stream.h"
+
+namespace Common {
+
+class Archive;
+
+class ArchiveMember {
+public:
+	virtual ~ArchiveMember() {}
+	virtual SeekableReadStream *createReadStream() const = 0;
+	virtual String getName() const = 0;
+};
+
+typedef SharedPtr<ArchiveMember> ArchiveMemberPtr;
+typedef List<ArchiveMemberPtr> ArchiveMemberList;
+
+class GenericArchiveMember : public ArchiveMember {
+public:
+	GenericArchiveMember(const String &name, const Archive *parent) : _parent(parent), _name(name) {}
+
+	SeekableReadStream *createReadStream() const;
+	String getName() const { return _name; }
+
+private:
+	const Archive *_parent;
+	const String _name;
+};
+
+class Archive {
+public:
+	virtual ~Archive() {}
+
+	virtual bool hasFile(const String &name) const = 0;
+	virtual int listMatchingMembers(ArchiveMemberList &list, const String &pattern) const;
+	virtual int listMembers(ArchiveMemberList &list) const = 0;
+	virtual const ArchiveMemberPtr getMember(const String &name) const = 0;
+	virtual SeekableReadStream *createReadStreamForMember(const String &name) const = 0;
+};
+
+/**
+ * A set of archives, which are searched in the order they were added
+ */
+class SearchSet : public Archive {
+public:
+	~SearchSet();
+
+	void add(const String &name, Archive *arch, int priority = 0, bool autoFree = true);
+
+	/**
+	 * Adds the files of a directory of the host file system
+	 */
+	void addDirectory(const String &name, const String &directory, int priority = 0);
+
+	bool hasFile(const String &name) const;
+	int listMatchingMembers(ArchiveMemberList &list, const String &pattern) const;
+	int listMembers(ArchiveMemberList &list) const;
+	const ArchiveMemberPtr getMember(const String &name) const;
+	SeekableReadStream *createReadStreamForMember(const String &name) const;
+
+private:
+	struct Node {
+		String name;
+		Archive *arch;
+		bool autoFree;
+	};
+
+	List<Node> _list;
+};
+
+class SearchManager : public SearchSet {
+public:
+	static SearchManager &instance();
+};
+
+} // End of namespace Common
+
+#define SearchMan Common::SearchManager::instance()
+
+#endif
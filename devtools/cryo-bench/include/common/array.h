@@ -0,0 +1,79 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ARRAY_H
+#define COMMON_ARRAY_H
+
+#include <vector>
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+template<class T>
+class Array {
+public:
+	typedef T *iterator;
+	typedef const T *const_iterator;
+	typedef T value_type;
+	typedef uint size_type;
+
+	Array() {}
+	explicit Array(size_type count) : _storage(count) {}
+	Array(size_type count, const T &value) : _storage(count, value) {}
+	Array(const T *array, size_type n) : _storage(array, array + n) {}
+
+	void push_back(const T &element) { _storage.push_back(element); }
+	void pop_back() { _storage.pop_back(); }
+	void insert_at(size_type idx, const T &element) { _storage.insert(_storage.begin() + idx, element); }
+
+	T remove_at(size_type idx) {
+		T tmp = _storage[idx];
+		_storage.erase(_storage.begin() + idx);
+		return tmp;
+	}
+
+	T &operator[](size_type idx) { return _storage[idx]; }
+	const T &operator[](size_type idx) const { return _storage[idx]; }
+	T &front() { return _storage.front(); }
+	const T &front() const { return _storage.front(); }
+	T &back() { return _storage.back(); }
+	const T &back() const { return _storage.back(); }
+
+	size_type size() const { return _storage.size(); }
+	bool empty() const { return _storage.empty(); }
+	void clear() { _storage.clear(); }
+	void resize(size_type newSize) { _storage.resize(newSize); }
+	void reserve(size_type newCapacity) { _storage.reserve(newCapacity); }
+
+	iterator begin() { return _storage.empty() ? 0 : &_storage[0]; }
+	iterator end() { return begin() + _storage.size(); }
+	const_iterator begin() const { return _storage.empty() ? 0 : &_storage[0]; }
+	const_iterator end() const { return begin() + _storage.size(); }
+
+private:
+	std::vector<T> _storage;
+};
+
+} // End of namespace Common
+
+#endif
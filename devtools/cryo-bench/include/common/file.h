@@ -0,0 +1,77 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FILE_H
+#define COMMON_FILE_H
+
+#include "common/archive.h"
+
+namespace Common {
+
+/**
+ * A file which is looked up in SearchMan
+ */
+class File : public SeekableReadStream {
+public:
+	File();
+	~File();
+
+	static bool exists(const String &filename);
+
+	bool open(const String &filename);
+	void close();
+	bool isOpen() const { return _handle != 0; }
+
+	uint32 read(void *dataPtr, uint32 dataSize);
+	bool eos() const;
+	void clearErr();
+	int32 pos() const;
+	int32 size() const;
+	bool seek(int32 offs, int whence = SEEK_SET);
+
+private:
+	SeekableReadStream *_handle;
+};
+
+/**
+ * A file of the host file system which is written to
+ */
+class DumpFile : public WriteStream {
+public:
+	DumpFile();
+	~DumpFile();
+
+	bool open(const String &filename);
+	void close();
+	bool isOpen() const { return _handle != 0; }
+
+	uint32 write(const void *dataPtr, uint32 dataSize);
+	bool flush();
+	int32 pos() const;
+
+private:
+	FILE *_handle;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,91 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_HASHMAP_H
+#define COMMON_HASHMAP_H
+
+#include <unordered_map>
+
+#include "common/func.h"
+
+namespace Common {
+
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class HashMap {
+public:
+	struct Node {
+		Key _key;
+		Val _value;
+	};
+
+private:
+	struct StdHash {
+		size_t operator()(const Key &key) const { return HashFunc()(key); }
+	};
+
+	struct StdEqual {
+		bool operator()(const Key &x, const Key &y) const { return EqualFunc()(x, y); }
+	};
+
+	typedef std::unordered_map<Key, Node, StdHash, StdEqual> Storage;
+
+public:
+	class iterator {
+	public:
+		iterator() {}
+		iterator(typename Storage::iterator it) : _it(it) {}
+		Node &operator*() const { return _it->second; }
+		Node *operator->() const { return &_it->second; }
+		iterator &operator++() { ++_it; return *this; }
+		bool operator==(const iterator &x) const { return _it == x._it; }
+		bool operator!=(const iterator &x) const { return _it != x._it; }
+
+	private:
+		friend class HashMap;
+		typename Storage::iterator _it;
+	};
+
+	bool contains(const Key &key) const { return _storage.count(key) != 0; }
+
+	Val &operator[](const Key &key) {
+		Node &node = _storage[key];
+		node._key = key;
+		return node._value;
+	}
+
+	iterator find(const Key &key) { return iterator(_storage.find(key)); }
+	iterator begin() { return iterator(_storage.begin()); }
+	iterator end() { return iterator(_storage.end()); }
+
+	void erase(const Key &key) { _storage.erase(key); }
+	void erase(iterator it) { _storage.erase(it._it); }
+	void clear() { _storage.clear(); }
+	uint size() const { return _storage.size(); }
+	bool empty() const { return _storage.empty(); }
+
+private:
+	Storage _storage;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,67 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_LIST_H
+#define COMMON_LIST_H
+
+#include <list>
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+template<class T>
+class List {
+public:
+	typedef typename std::list<T>::iterator iterator;
+	typedef typename std::list<T>::const_iterator const_iterator;
+	typedef T value_type;
+
+	void push_front(const T &element) { _list.push_front(element); }
+	void push_back(const T &element) { _list.push_back(element); }
+	void pop_front() { _list.pop_front(); }
+	void pop_back() { _list.pop_back(); }
+	iterator insert(iterator pos, const T &element) { return _list.insert(pos, element); }
+	iterator erase(iterator pos) { return _list.erase(pos); }
+	void remove(const T &val) { _list.remove(val); }
+
+	T &front() { return _list.front(); }
+	const T &front() const { return _list.front(); }
+	T &back() { return _list.back(); }
+	const T &back() const { return _list.back(); }
+
+	uint size() const { return _list.size(); }
+	bool empty() const { return _list.empty(); }
+	void clear() { _list.clear(); }
+
+	iterator begin() { return _list.begin(); }
+	iterator end() { return _list.end(); }
+	const_iterator begin() const { return _list.begin(); }
+	const_iterator end() const { return _list.end(); }
+
+private:
+	std::list<T> _list;
+};
+
+} // End of namespace Common
+
+#endif
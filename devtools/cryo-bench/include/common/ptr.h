@@ -0,0 +1,55 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_PTR_H
+#define COMMON_PTR_H
+
+#include <memory>
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+template<class T>
+class SharedPtr {
+public:
+	SharedPtr() {}
+	explicit SharedPtr(T *p) : _pointer(p) {}
+
+	T &operator*() const { return *_pointer; }
+	T *operator->() const { return _pointer.get(); }
+	T *get() const { return _pointer.get(); }
+	operator bool() const { return _pointer.get() != 0; }
+	bool operator==(const SharedPtr &x) const { return _pointer == x._pointer; }
+	bool operator!=(const SharedPtr &x) const { return _pointer != x._pointer; }
+
+	void reset() { _pointer.reset(); }
+	bool unique() const { return _pointer.use_count() == 1; }
+	int refCount() const { return _pointer.use_count(); }
+
+private:
+	std::shared_ptr<T> _pointer;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,52 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_RANDOM_H
+#define COMMON_RANDOM_H
+
+#include "common/str.h"
+
+namespace Common {
+
+/**
+ * A pseudo random number generator with a fixed seed, so that the corpus
+ * and the benchmark data are the same on every run
+ */
+class RandomSource {
+public:
+	RandomSource(const String &name) : _randSeed(0x1234567) {}
+
+	uint getRandomNumber(uint max) {
+		_randSeed = 0xDEADBF03 * (_randSeed + 1);
+		_randSeed = (_randSeed >> 13) | (_randSeed << 19);
+		return _randSeed % (max + 1);
+	}
+
+	uint getRandomNumberRng(uint min, uint max) { return getRandomNumber(max - min) + min; }
+
+private:
+	uint32 _randSeed;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,82 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_RECT_H
+#define COMMON_RECT_H
+
+#include "common/util.h"
+
+namespace Common {
+
+struct Rect {
+	int16 top, left;
+	int16 bottom, right;
+
+	Rect() : top(0), left(0), bottom(0), right(0) {}
+	Rect(int16 w, int16 h) : top(0), left(0), bottom(h), right(w) {}
+	Rect(int16 x1, int16 y1, int16 x2, int16 y2) : top(y1), left(x1), bottom(y2), right(x2) {}
+
+	bool operator==(const Rect &rhs) const { return top == rhs.top && left == rhs.left && bottom == rhs.bottom && right == rhs.right; }
+	bool operator!=(const Rect &rhs) const { return !(*this == rhs); }
+
+	int16 width() const { return right - left; }
+	int16 height() const { return bottom - top; }
+
+	bool contains(int16 x, int16 y) const { return left <= x && x < right && top <= y && y < bottom; }
+	bool contains(const Rect &r) const { return left <= r.left && r.right <= right && top <= r.top && r.bottom <= bottom; }
+	bool intersects(const Rect &r) const { return left < r.right && r.left < right && top < r.bottom && r.top < bottom; }
+	bool isEmpty() const { return left >= right || top >= bottom; }
+
+	void extend(const Rect &r) {
+		left = MIN(left, r.left);
+		right = MAX(right, r.right);
+		top = MIN(top, r.top);
+		bottom = MAX(bottom, r.bottom);
+	}
+
+	void clip(const Rect &r) {
+		if (top < r.top) top = r.top;
+		else if (top > r.bottom) top = r.bottom;
+
+		if (left < r.left) left = r.left;
+		else if (left > r.right) left = r.right;
+
+		if (bottom > r.bottom) bottom = r.bottom;
+		else if (bottom < r.top) bottom = r.top;
+
+		if (right > r.right) right = r.right;
+		else if (right < r.left) right = r.left;
+	}
+
+	void clip(int16 maxw, int16 maxh) { clip(Rect(0, 0, maxw, maxh)); }
+
+	void translate(int16 dx, int16 dy) {
+		left += dx;
+		right += dx;
+		top += dy;
+		bottom += dy;
+	}
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,45 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SAVEFILE_H
+#define COMMON_SAVEFILE_H
+
+#include "common/str-array.h"
+#include "common/stream.h"
+
+namespace Common {
+
+typedef SeekableReadStream InSaveFile;
+typedef WriteStream OutSaveFile;
+
+class SaveFileManager {
+public:
+	virtual ~SaveFileManager() {}
+
+	virtual OutSaveFile *openForSaving(const String &name, bool compress = true) = 0;
+	virtual InSaveFile *openForLoading(const String &name) = 0;
+	virtual bool removeSavefile(const String &name) = 0;
+};
+
+} // End of namespace Common
+
+#endif
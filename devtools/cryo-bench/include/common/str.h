@@ -0,0 +1,97 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_STRING_H
+#define COMMON_STRING_H
+
+#include <string>
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+template<class T> class Array;
+class String;
+
+typedef Array<String> StringArray;
+
+class String {
+public:
+	static const uint32 npos = 0xFFFFFFFF;
+
+	String() {}
+	String(const char *str) : _str(str) {}
+	String(const char *str, uint32 len) : _str(str, len) {}
+	String(const char *beginP, const char *endP) : _str(beginP, endP) {}
+	explicit String(char c) : _str(1, c) {}
+
+	const char *c_str() const { return _str.c_str(); }
+	uint size() const { return _str.size(); }
+	bool empty() const { return _str.empty(); }
+	char operator[](int idx) const { return _str[idx]; }
+	char lastChar() const { return _str.empty() ? 0 : _str[_str.size() - 1]; }
+
+	String &operator+=(const String &str) { _str += str._str; return *this; }
+	String &operator+=(const char *str) { _str += str; return *this; }
+	String &operator+=(char c) { _str += c; return *this; }
+
+	bool operator==(const String &x) const { return _str == x._str; }
+	bool operator==(const char *x) const { return _str == x; }
+	bool operator!=(const String &x) const { return _str != x._str; }
+	bool operator!=(const char *x) const { return _str != x; }
+	bool operator<(const String &x) const { return _str < x._str; }
+
+	bool equalsIgnoreCase(const String &x) const;
+	bool equalsIgnoreCase(const char *x) const;
+	bool hasPrefix(const String &x) const;
+	bool hasSuffix(const String &x) const;
+	bool contains(const String &x) const { return _str.find(x._str) != std::string::npos; }
+	bool contains(char x) const { return _str.find(x) != std::string::npos; }
+
+	/**
+	 * Matches the string against a pattern in which * matches any number of
+	 * characters and ? a single one
+	 */
+	bool matchString(const String &pattern, bool ignoreCase = false) const;
+
+	void toLowercase();
+	void toUppercase();
+	void clear() { _str.clear(); }
+
+	static String format(const char *fmt, ...) GCC_PRINTF(1, 2);
+
+private:
+	std::string _str;
+};
+
+String operator+(const String &x, const String &y);
+String operator+(const String &x, const char *y);
+String operator+(const char *x, const String &y);
+String operator+(const String &x, char y);
+
+int scumm_stricmp(const char *s1, const char *s2);
+
+} // End of namespace Common
+
+using Common::scumm_stricmp;
+
+#endif
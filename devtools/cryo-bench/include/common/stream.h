@@ -0,0 +1,113 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_STREAM_H
+#define COMMON_STREAM_H
+
+#include "common/endian.h"
+#include "common/str.h"
+#include "common/types.h"
+
+namespace Common {
+
+class Stream {
+public:
+	virtual ~Stream() {}
+
+	virtual bool err() const { return false; }
+	virtual void clearErr() {}
+};
+
+class WriteStream : virtual public Stream {
+public:
+	virtual uint32 write(const void *dataPtr, uint32 dataSize) = 0;
+	virtual bool flush() { return true; }
+	virtual void finalize() { flush(); }
+	virtual int32 pos() const = 0;
+
+	void writeByte(byte value) { write(&value, 1); }
+
+	void writeUint16LE(uint16 value) {
+		byte b[2];
+		WRITE_LE_UINT16(b, value);
+		write(b, 2);
+	}
+
+	void writeUint32LE(uint32 value) {
+		byte b[4];
+		WRITE_LE_UINT32(b, value);
+		write(b, 4);
+	}
+
+	void writeUint32BE(uint32 value) {
+		byte b[4];
+		WRITE_BE_UINT32(b, value);
+		write(b, 4);
+	}
+};
+
+class ReadStream : virtual public Stream {
+public:
+	virtual bool eos() const = 0;
+	virtual uint32 read(void *dataPtr, uint32 dataSize) = 0;
+
+	byte readByte() {
+		byte b = 0;
+		read(&b, 1);
+		return b;
+	}
+
+	int8 readSByte() { return (int8)readByte(); }
+
+	uint16 readUint16LE() {
+		byte b[2] = { 0, 0 };
+		read(b, 2);
+		return READ_LE_UINT16(b);
+	}
+
+	uint32 readUint32LE() {
+		byte b[4] = { 0, 0, 0, 0 };
+		read(b, 4);
+		return READ_LE_UINT32(b);
+	}
+
+	uint32 readUint32BE() {
+		byte b[4] = { 0, 0, 0, 0 };
+		read(b, 4);
+		return READ_BE_UINT32(b);
+	}
+
+	int16 readSint16LE() { return (int16)readUint16LE(); }
+	int32 readSint32LE() { return (int32)readUint32LE(); }
+};
+
+class SeekableReadStream : virtual public ReadStream {
+public:
+	virtual int32 pos() const = 0;
+	virtual int32 size() const = 0;
+	virtual bool seek(int32 offset, int whence = SEEK_SET) = 0;
+	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,60 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SUBSTREAM_H
+#define COMMON_SUBSTREAM_H
+
+#include "common/stream.h"
+
+namespace Common {
+
+/**
+ * A view on the range [begin, end) of a parent stream. The parent is seeked
+ * to the position of the substream before every read, so several substreams
+ * can share a parent.
+ */
+class SafeSeekableSubReadStream : public SeekableReadStream {
+public:
+	SafeSeekableSubReadStream(SeekableReadStream *parentStream, uint32 begin, uint32 end,
+			DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO);
+	~SafeSeekableSubReadStream();
+
+	uint32 read(void *dataPtr, uint32 dataSize);
+	bool eos() const { return _eos; }
+	void clearErr() { _eos = false; }
+
+	int32 pos() const { return _pos - _begin; }
+	int32 size() const { return _end - _begin; }
+	bool seek(int32 offset, int whence = SEEK_SET);
+
+private:
+	SeekableReadStream *_parentStream;
+	DisposeAfterUse::Flag _disposeParentStream;
+	uint32 _begin;
+	uint32 _end;
+	uint32 _pos;
+	bool _eos;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,49 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SYSTEM_H
+#define COMMON_SYSTEM_H
+
+#include "common/savefile.h"
+#include "common/util.h"
+#include "graphics/palette.h"
+
+/**
+ * The backend interface, reduced to the calls which the engine sources make
+ */
+class OSystem {
+public:
+	virtual ~OSystem() {}
+
+	virtual PaletteManager *getPaletteManager() = 0;
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) = 0;
+	virtual void updateScreen() = 0;
+
+	virtual uint32 getMillis(bool skipRecord = false) = 0;
+	virtual void delayMillis(uint msecs) = 0;
+
+	virtual Common::SaveFileManager *getSavefileManager() = 0;
+};
+
+extern OSystem *g_system;
+
+#endif
@@ -0,0 +1,64 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_ENGINE_H
+#define ENGINES_ENGINE_H
+
+#include "common/str.h"
+#include "common/system.h"
+
+namespace Common {
+
+enum ErrorCode {
+	kNoError = 0
+};
+
+class Error {
+public:
+	Error(ErrorCode code = kNoError) : _code(code) {}
+	ErrorCode getCode() const { return _code; }
+
+private:
+	ErrorCode _code;
+};
+
+} // End of namespace Common
+
+class Engine {
+public:
+	enum EngineFeature {
+		kSupportsRTL
+	};
+
+	Engine(OSystem *syst) : _system(syst) {}
+	virtual ~Engine() {}
+
+	virtual Common::Error run() = 0;
+	virtual bool hasFeature(EngineFeature f) const { return false; }
+
+	OSystem *_system;
+
+protected:
+	const Common::String _targetName;
+};
+
+#endif
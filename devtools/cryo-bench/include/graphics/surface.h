@@ -0,0 +1,55 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_SURFACE_H
+#define GRAPHICS_SURFACE_H
+
+#include "common/rect.h"
+#include "graphics/pixelformat.h"
+
+namespace Graphics {
+
+struct Surface {
+	uint16 w;
+	uint16 h;
+	uint16 pitch;
+	PixelFormat format;
+
+	Surface() : w(0), h(0), pitch(0), format(), pixels(0) {}
+
+	const void *getPixels() const { return pixels; }
+	void *getPixels() { return pixels; }
+
+	const void *getBasePtr(int x, int y) const { return (const byte *)pixels + y * pitch + x * format.bytesPerPixel; }
+	void *getBasePtr(int x, int y) { return (byte *)pixels + y * pitch + x * format.bytesPerPixel; }
+
+	void create(uint16 width, uint16 height, const PixelFormat &f);
+	void free();
+	void init(uint16 width, uint16 height, uint16 newPitch, void *newPixels, const PixelFormat &f);
+
+private:
+	void *pixels;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,379 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// cryo-bench runs the benchmarks of the engine without ScummVM, on a
+// synthetic corpus or on the data of a game directory. It prints one line of
+// key=value pairs per result, and with -c, checks the decoders against the
+// data the corpus was made from.
+
+#include "common/debug.h"
+#include "common/memstream.h"
+#include "common/random.h"
+
+#include "cryo/benchmark.h"
+#include "cryo/blit.h"
+#include "cryo/cryo.h"
+#include "cryo/diskcache.h"
+#include "cryo/font.h"
+#include "cryo/hsq.h"
+#include "cryo/resource.h"
+#include "cryo/screen.h"
+#include "cryo/text.h"
+
+#include "corpus.h"
+#include "system.h"
+
+#define DEFAULT_ITERATIONS 10
+
+// The largest source and how far the buffers are moved off their alignment
+// in the nibble expansion checks
+#define NIBBLE_CHECK_SIZE 4096
+#define NIBBLE_CHECK_MISALIGNMENT 16
+
+// The size of the entries stored by the disk cache check, 16 of them add up
+// to several of its batches
+#define DISK_CACHE_CHECK_SIZE (64 * 1024)
+
+static void printUsage(const char *name) {
+	fprintf(stderr, "Usage: %s [-c] [-n <iterations>] [-g <game directory>] [-d <debug level>]\n", name);
+	fprintf(stderr, "  -c  checks the decoders against the synthetic corpus, and exits with 1 on failure\n");
+	fprintf(stderr, "  -n  how many times every benchmark goes over its data, %d by default\n", DEFAULT_ITERATIONS);
+	fprintf(stderr, "  -g  runs the benchmarks on the game data in a directory, instead of the synthetic corpus\n");
+	fprintf(stderr, "  -d  prints the engine's debug messages up to a level\n");
+}
+
+static bool printCheck(const char *name, uint items, const Common::String &failure) {
+	if (failure.empty())
+		printf("check name=%s items=%d result=ok\n", name, items);
+	else
+		printf("check name=%s items=%d result=fail reason=\"%s\"\n", name, items, failure.c_str());
+
+	return failure.empty();
+}
+
+/**
+ * Decompresses every member of the corpus with both HSQ decoders, and
+ * through the resource manager
+ */
+static bool checkHsq(const CorpusArchive &corpus, Cryo::CryoEngine &engine) {
+	const Common::StringArray &names = corpus.getMemberNames();
+	Cryo::ResourceManager *resMan = engine.getResourceManager();
+	Common::Array<byte> output(0x10000);
+	Common::String failure;
+	uint items = 0;
+
+	for (uint i = 0; i < names.size() && failure.empty(); i++) {
+		const Common::Array<byte> &expected = corpus.getUnpacked(names[i]);
+		Common::SeekableReadStream *rsrc = corpus.createReadStreamForMember(names[i]);
+		Common::Array<byte> packed(rsrc->size());
+		rsrc->read(packed.begin(), packed.size());
+		delete rsrc;
+
+		uint16 unpackedSize, packedSize;
+		if (!Cryo::parseHsqHeader(packed.begin(), unpackedSize, packedSize) || unpackedSize != expected.size() ||
+				packedSize != packed.size()) {
+			failure = Common::String::format("%s has a bad header", names[i].c_str());
+			break;
+		}
+
+		uint32 size = Cryo::decompressHsq(packed.begin() + 6, packed.size() - 6, output.begin(), unpackedSize);
+		if (size != expected.size() || memcmp(output.begin(), expected.begin(), size)) {
+			failure = Common::String::format("decompressHsq() differs on %s", names[i].c_str());
+			break;
+		}
+
+		Common::MemoryReadStream source(packed.begin() + 6, packed.size() - 6);
+		Cryo::HsqReadStream hsq(&source);
+		size = hsq.read(output.begin(), unpackedSize);
+		if (size != expected.size() || memcmp(output.begin(), expected.begin(), size)) {
+			failure = Common::String::format("HsqReadStream differs on %s", names[i].c_str());
+			break;
+		}
+
+		Common::SeekableReadStream *resource = resMan->getResource(names[i]);
+		size = resource->read(output.begin(), output.size());
+		delete resource;
+		if (size != expected.size() || memcmp(output.begin(), expected.begin(), size)) {
+			failure = Common::String::format("ResourceManager::getResource() differs on %s", names[i].c_str());
+			break;
+		}
+
+		items++;
+	}
+
+	return printCheck("hsq", items, failure);
+}
+
+/**
+ * Reads back resources stored in the disk cache, and checks that entries
+ * are only used for the packed data they were made from
+ */
+static bool checkDiskCache(const CorpusArchive &corpus) {
+	static const char *const cacheName = "cryo-bench.cache";
+	const Common::StringArray &names = corpus.getMemberNames();
+	Common::String failure;
+	uint items = 0;
+
+	// The first pass fills the cache, the second one reads from it
+	for (uint pass = 0; pass < 2 && failure.empty(); pass++) {
+		Cryo::ResourceManager resMan(false);
+		resMan.enableDiskCache(cacheName);
+
+		for (uint i = 0; i < names.size() && failure.empty(); i++) {
+			const Common::Array<byte> &expected = corpus.getUnpacked(names[i]);
+			Common::SeekableReadStream *resource = resMan.getResource(names[i]);
+			Common::Array<byte> output(resource->size());
+			resource->read(output.begin(), output.size());
+			delete resource;
+
+			if (output.size() != expected.size() || memcmp(output.begin(), expected.begin(), output.size()))
+				failure = Common::String::format("%s differs in pass %d", names[i].c_str(), pass);
+
+			items++;
+		}
+	}
+
+	if (failure.empty()) {
+		byte *data = (byte *)malloc(4);
+		memcpy(data, "data", 4);
+
+		{
+			Cryo::ResourceDiskCache diskCache(cacheName, 1);
+			diskCache.store("changed.hsq", 100, 1234, Cryo::ResourceBufferPtr(new Cryo::ResourceBuffer(data, 4)));
+		}
+
+		Cryo::ResourceDiskCache diskCache(cacheName, 1);
+		if (!diskCache.load("changed.hsq", 100, 1234))
+			failure = "a stored entry wasn't found";
+		else if (diskCache.load("changed.hsq", 100, 1235))
+			failure = "an entry was used for different packed data";
+
+		items++;
+	}
+
+	// Stored data must be written and released in batches, rather than be
+	// kept until the cache is destroyed
+	if (failure.empty()) {
+		Common::Array<Cryo::ResourceBufferPtr> buffers;
+
+		{
+			Cryo::ResourceDiskCache diskCache(cacheName, 2);
+			for (uint i = 0; i < 16; i++) {
+				byte *data = (byte *)malloc(DISK_CACHE_CHECK_SIZE);
+				memset(data, i, DISK_CACHE_CHECK_SIZE);
+				buffers.push_back(Cryo::ResourceBufferPtr(new Cryo::ResourceBuffer(data, DISK_CACHE_CHECK_SIZE)));
+				diskCache.store(Common::String::format("batch%d.hsq", i), i, i, buffers[i]);
+			}
+
+			uint released = 0;
+			for (uint i = 0; i < buffers.size(); i++)
+				released += buffers[i].unique() ? 1 : 0;
+			if (released < buffers.size() / 2)
+				failure = Common::String::format("only %d of %d stored buffers were released", released, buffers.size());
+		}
+
+		Cryo::ResourceDiskCache diskCache(cacheName, 2);
+		for (uint i = 0; i < buffers.size() && failure.empty(); i++) {
+			Cryo::ResourceBufferPtr buffer = diskCache.load(Common::String::format("batch%d.hsq", i), i, i);
+			if (!buffer || buffer->size != DISK_CACHE_CHECK_SIZE || memcmp(buffer->data, buffers[i]->data, DISK_CACHE_CHECK_SIZE))
+				failure = Common::String::format("batch entry %d wasn't read back", i);
+
+			items++;
+		}
+
+		diskCache.clear();
+	}
+
+	return printCheck("disk_cache", items, failure);
+}
+
+/**
+ * Checks every version of expandNibbles() the CPU supports against the
+ * scalar one, over random data, lengths, alignments and palette offsets.
+ * The bytes around the output must stay untouched.
+ */
+static bool checkNibbles() {
+	Common::RandomSource rnd("cryo_bench_nibbles");
+	Common::Array<byte> source(NIBBLE_CHECK_SIZE + NIBBLE_CHECK_MISALIGNMENT);
+	Common::Array<byte> expected(NIBBLE_CHECK_SIZE * 2 + NIBBLE_CHECK_MISALIGNMENT * 2);
+	Common::Array<byte> output(expected.size());
+	bool passed = true;
+
+	for (const Cryo::NibbleExpander *expander = Cryo::getNibbleExpanders(); expander->name; expander++) {
+		Common::String failure;
+		uint items = 0;
+
+		for (uint i = 0; i < 1000 && failure.empty(); i++) {
+			// Small sizes cover the loop tails, which the vector loops leave
+			// to the scalar code
+			uint32 byteCount = (i < 100) ? i : rnd.getRandomNumber(NIBBLE_CHECK_SIZE);
+			uint srcShift = rnd.getRandomNumber(NIBBLE_CHECK_MISALIGNMENT - 1);
+			uint dstShift = rnd.getRandomNumber(NIBBLE_CHECK_MISALIGNMENT - 1);
+			byte offset = rnd.getRandomNumber(255);
+
+			for (uint32 j = 0; j < source.size(); j++)
+				source[j] = rnd.getRandomNumber(255);
+			for (uint32 j = 0; j < expected.size(); j++)
+				expected[j] = output[j] = rnd.getRandomNumber(255);
+
+			Cryo::expandNibblesScalar(source.begin() + srcShift, expected.begin() + dstShift, byteCount * 2, offset);
+			expander->expand(source.begin() + srcShift, output.begin() + dstShift, byteCount * 2, offset);
+
+			if (memcmp(expected.begin(), output.begin(), expected.size())) {
+				failure = Common::String::format("differs from the scalar version for %d pixels at offset %d, alignments %d and %d",
+						byteCount * 2, offset, srcShift, dstShift);
+			}
+
+			items++;
+		}
+
+		Common::String name = Common::String("nibbles_") + expander->name;
+		passed &= printCheck(name.c_str(), items, failure);
+	}
+
+	return passed;
+}
+
+/**
+ * Checks that text rendered through the text cache looks the same as text
+ * drawn directly, over a background of random pixels
+ */
+static bool checkFont(const char *name, Cryo::Font &font) {
+	Common::RandomSource rnd("cryo_bench_text");
+	Graphics::Surface expected, output;
+	expected.create(320, 200, Graphics::PixelFormat::createFormatCLUT8());
+	output.create(320, 200, Graphics::PixelFormat::createFormatCLUT8());
+	Common::String failure;
+	uint items = 0;
+
+	for (uint i = 0; i < 200 && failure.empty(); i++) {
+		Common::String text;
+		uint length = rnd.getRandomNumberRng(1, 40);
+		for (uint j = 0; j < length; j++)
+			text += (char)((rnd.getRandomNumber(5) == 0) ? ' ' : rnd.getRandomNumberRng(33, 126));
+
+		byte color = rnd.getRandomNumber(255);
+		uint16 maxWidth = rnd.getRandomNumber(2) ? rnd.getRandomNumberRng(16, 200) : 0;
+		int16 x = rnd.getRandomNumberRng(0, 100);
+		int16 y = rnd.getRandomNumberRng(0, 100);
+
+		for (uint j = 0; j < 320 * 200; j++)
+			((byte *)expected.getPixels())[j] = ((byte *)output.getPixels())[j] = rnd.getRandomNumber(255);
+
+		Cryo::TextLayoutPtr layout = font.layoutText(text, maxWidth);
+		font.drawLayout(expected, Common::Rect(320, 200), *layout, x, y, color);
+		Cryo::blitFrame(output, Common::Rect(320, 200), *font.renderText(text, color, maxWidth), x, y);
+
+		if (memcmp(expected.getPixels(), output.getPixels(), 320 * 200))
+			failure = Common::String::format("string %d of %d characters in color %d differs from the text drawn directly", i, text.size(), color);
+
+		items++;
+	}
+
+	// All the kinds of line breaks must give the same layout
+	if (failure.empty()) {
+		uint16 height = font.layoutText("line\nline")->height;
+		if (font.layoutText("line\rline")->height != height || font.layoutText("line\r\nline")->height != height)
+			failure = "line breaks give different layout heights";
+
+		items++;
+	}
+
+	expected.free();
+	output.free();
+
+	return printCheck(name, items, failure);
+}
+
+int main(int argc, char *argv[]) {
+	bool check = false;
+	uint iterations = DEFAULT_ITERATIONS;
+	const char *gameDir = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-c")) {
+			check = true;
+		} else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			iterations = MAX(atoi(argv[++i]), 1);
+		} else if (!strcmp(argv[i], "-g") && i + 1 < argc) {
+			gameDir = argv[++i];
+		} else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+			gDebugLevel = atoi(argv[++i]);
+		} else {
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+
+	HeadlessSystem system(320, 200);
+	g_system = &system;
+
+	// The checks need the data the corpus was made from, so they always run
+	// on the synthetic corpus
+	CorpusArchive *corpus = 0;
+	ADGameDescription gameDescription = { "cryo", ADGF_NO_FLAGS };
+
+	if (gameDir && !check) {
+		SearchMan.addDirectory(gameDir, gameDir);
+		Common::ArchiveMemberList members;
+		if (!SearchMan.listMatchingMembers(members, "*.hsq") && !SearchMan.hasFile("dune.dat"))
+			error("%s doesn't contain the data of the game", gameDir);
+		if (SearchMan.hasFile("dune.dat"))
+			gameDescription.flags |= ADGF_CD;
+	} else {
+		corpus = new CorpusArchive();
+		SearchMan.add("corpus", corpus, 0, false);
+	}
+
+	int exitCode = 0;
+
+	{
+		Cryo::CryoEngine engine(&system, &gameDescription);
+
+		if (corpus)
+			printf("corpus source=synthetic resources=%d bytes=%d\n", corpus->getMemberNames().size(), corpus->getPackedSize());
+		else
+			printf("corpus source=%s cd=%d\n", gameDir, engine.isCD());
+
+		if (check) {
+			bool passed = checkHsq(*corpus, engine);
+			passed &= checkDiskCache(*corpus);
+			passed &= checkNibbles();
+
+			Cryo::FixedFont fixedFont("dunechar.hsq", &engine);
+			passed &= checkFont("text_fixed_font", fixedFont);
+			Cryo::SpriteFont spriteFont("generic.hsq", &engine);
+			passed &= checkFont("text_sprite_font", spriteFont);
+			exitCode = passed ? 0 : 1;
+		} else {
+			Common::Array<Cryo::BenchmarkResult> results;
+			Cryo::Benchmark benchmark(&engine);
+			benchmark.run(iterations, results);
+
+			for (uint i = 0; i < results.size(); i++)
+				printf("%s\n", results[i].toString().c_str());
+		}
+	}
+
+	delete corpus;
+	return exitCode;
+}
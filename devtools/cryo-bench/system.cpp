@@ -0,0 +1,140 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <chrono>
+#include <thread>
+
+#include "common/memstream.h"
+
+#include "system.h"
+
+OSystem *g_system = 0;
+
+HeadlessPaletteManager::HeadlessPaletteManager() {
+	memset(_colors, 0, sizeof(_colors));
+}
+
+void HeadlessPaletteManager::setPalette(const byte *colors, uint start, uint num) {
+	assert(start + num <= 256);
+	memcpy(_colors + start * 3, colors, num * 3);
+}
+
+void HeadlessPaletteManager::grabPalette(byte *colors, uint start, uint num) {
+	assert(start + num <= 256);
+	memcpy(colors, _colors + start * 3, num * 3);
+}
+
+/**
+ * Collects the data of a save file, which is stored when it's finalized
+ */
+class MemoryOutSaveFile : public Common::OutSaveFile {
+public:
+	MemoryOutSaveFile(MemorySaveFileManager *manager, const Common::String &name)
+		: _manager(manager), _name(name), _finalized(false) {}
+
+	~MemoryOutSaveFile() {
+		finalize();
+	}
+
+	uint32 write(const void *dataPtr, uint32 dataSize) {
+		const byte *data = (const byte *)dataPtr;
+		for (uint32 i = 0; i < dataSize; i++)
+			_data.push_back(data[i]);
+		return dataSize;
+	}
+
+	void finalize() {
+		if (!_finalized)
+			_manager->storeFile(_name, _data);
+		_finalized = true;
+	}
+
+	int32 pos() const {
+		return _data.size();
+	}
+
+private:
+	MemorySaveFileManager *_manager;
+	Common::String _name;
+	Common::Array<byte> _data;
+	bool _finalized;
+};
+
+Common::OutSaveFile *MemorySaveFileManager::openForSaving(const Common::String &name, bool compress) {
+	return new MemoryOutSaveFile(this, name);
+}
+
+Common::InSaveFile *MemorySaveFileManager::openForLoading(const Common::String &name) {
+	if (!_files.contains(name))
+		return 0;
+
+	// The stream owns a copy, so that the file can be replaced while it's
+	// being read
+	const Common::Array<byte> &data = _files[name];
+	byte *copy = (byte *)malloc(MAX<uint>(data.size(), 1));
+	if (!data.empty())
+		memcpy(copy, data.begin(), data.size());
+
+	return new Common::MemoryReadStream(copy, data.size(), DisposeAfterUse::YES);
+}
+
+bool MemorySaveFileManager::removeSavefile(const Common::String &name) {
+	if (!_files.contains(name))
+		return false;
+
+	_files.erase(name);
+	return true;
+}
+
+void MemorySaveFileManager::storeFile(const Common::String &name, const Common::Array<byte> &data) {
+	_files[name] = data;
+}
+
+HeadlessSystem::HeadlessSystem(uint16 width, uint16 height) : _width(width), _height(height), _screenUpdates(0) {
+	_screen = new byte[width * height];
+	memset(_screen, 0, width * height);
+}
+
+HeadlessSystem::~HeadlessSystem() {
+	delete[] _screen;
+}
+
+void HeadlessSystem::copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {
+	assert(x >= 0 && y >= 0 && x + w <= _width && y + h <= _height);
+
+	const byte *src = (const byte *)buf;
+	for (int row = 0; row < h; row++)
+		memcpy(_screen + (y + row) * _width + x, src + row * pitch, w);
+}
+
+void HeadlessSystem::updateScreen() {
+	_screenUpdates++;
+}
+
+uint32 HeadlessSystem::getMillis(bool skipRecord) {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HeadlessSystem::delayMillis(uint msecs) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(msecs));
+}
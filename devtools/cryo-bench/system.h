@@ -0,0 +1,90 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_BENCH_SYSTEM_H
+#define CRYO_BENCH_SYSTEM_H
+
+#include "common/hash-str.h"
+#include "common/system.h"
+
+/**
+ * The palette of the headless system, which is only kept
+ */
+class HeadlessPaletteManager : public PaletteManager {
+public:
+	HeadlessPaletteManager();
+
+	void setPalette(const byte *colors, uint start, uint num);
+	void grabPalette(byte *colors, uint start, uint num);
+
+private:
+	byte _colors[256 * 3];
+};
+
+/**
+ * Keeps save files in memory, so that the disk cache can be benchmarked
+ * without touching the host file system
+ */
+class MemorySaveFileManager : public Common::SaveFileManager {
+public:
+	Common::OutSaveFile *openForSaving(const Common::String &name, bool compress = true);
+	Common::InSaveFile *openForLoading(const Common::String &name);
+	bool removeSavefile(const Common::String &name);
+
+	void storeFile(const Common::String &name, const Common::Array<byte> &data);
+
+private:
+	Common::HashMap<Common::String, Common::Array<byte> > _files;
+};
+
+/**
+ * A backend without a window. The screen is a buffer in memory, which the
+ * engine code draws to as usual.
+ */
+class HeadlessSystem : public OSystem {
+public:
+	HeadlessSystem(uint16 width, uint16 height);
+	~HeadlessSystem();
+
+	PaletteManager *getPaletteManager() { return &_paletteManager; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h);
+	void updateScreen();
+
+	uint32 getMillis(bool skipRecord = false);
+	void delayMillis(uint msecs);
+
+	Common::SaveFileManager *getSavefileManager() { return &_saveFileManager; }
+
+	const byte *getScreen() const { return _screen; }
+	uint32 getScreenUpdates() const { return _screenUpdates; }
+
+private:
+	HeadlessPaletteManager _paletteManager;
+	MemorySaveFileManager _saveFileManager;
+
+	uint16 _width;
+	uint16 _height;
+	byte *_screen;
+	uint32 _screenUpdates;
+};
+
+#endif
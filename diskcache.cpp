@@ -0,0 +1,261 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/debug.h"
+#include "common/endian.h"
+#include "common/savefile.h"
+#include "common/system.h"
+
+#include "cryo/diskcache.h"
+
+namespace Cryo {
+
+#define DISK_CACHE_TAG MKTAG('C', 'R', 'Y', 'C')
+#define DISK_CACHE_VERSION 3
+#define DISK_CACHE_HEADER_SIZE 16
+#define DISK_CACHE_ENTRY_SIZE 32
+#define DISK_CACHE_ALIGNMENT 16
+#define DISK_CACHE_MAX_SIZE (16 * 1024 * 1024)
+// New entries are written once this much data is waiting, which keeps the
+// memory held for them well below the resource cache budget
+#define DISK_CACHE_BATCH_SIZE (256 * 1024)
+#define DISK_CACHE_MAX_SEGMENTS 64
+
+static uint32 alignOffset(uint32 offset) {
+	return (offset + DISK_CACHE_ALIGNMENT - 1) & ~(DISK_CACHE_ALIGNMENT - 1);
+}
+
+ResourceDiskCache::ResourceDiskCache(const Common::String &fileName, uint32 fingerprint)
+	: _fileName(fileName), _fingerprint(fingerprint), _segmentCount(0), _totalSize(0), _pendingSize(0) {
+	while (_segmentCount < DISK_CACHE_MAX_SEGMENTS && readSegment(_segmentCount))
+		_segmentCount++;
+
+	// A missing segment ends the cache, a bad one invalidates all of it
+	if (_segmentCount < DISK_CACHE_MAX_SEGMENTS) {
+		Common::InSaveFile *file = g_system->getSavefileManager()->openForLoading(getSegmentName(_segmentCount));
+		if (file) {
+			debug(1, "Discarding resource cache %s", _fileName.c_str());
+			delete file;
+			clear();
+		}
+	}
+}
+
+ResourceDiskCache::~ResourceDiskCache() {
+	flush();
+}
+
+Common::String ResourceDiskCache::getSegmentName(uint segment) const {
+	if (segment == 0)
+		return _fileName;
+
+	return Common::String::format("%s.%d", _fileName.c_str(), segment);
+}
+
+bool ResourceDiskCache::readSegment(uint segment) {
+	Common::SeekableReadStream *file = g_system->getSavefileManager()->openForLoading(getSegmentName(segment));
+	if (!file)
+		return false;
+
+	uint32 tag = file->readUint32BE();
+	uint32 version = file->readUint32LE();
+	uint32 fingerprint = file->readUint32LE();
+	uint32 count = file->readUint32LE();
+	uint32 fileSize = file->size();
+
+	// The count is checked against the file size before the size of the
+	// table is computed, so that a corrupt count can't overflow it
+	if (tag != DISK_CACHE_TAG || version != DISK_CACHE_VERSION || fingerprint != _fingerprint ||
+			fileSize < DISK_CACHE_HEADER_SIZE || count > (fileSize - DISK_CACHE_HEADER_SIZE) / DISK_CACHE_ENTRY_SIZE) {
+		delete file;
+		return false;
+	}
+
+	uint firstEntry = _entries.size();
+	for (uint32 i = 0; i < count; i++) {
+		Entry entry;
+		file->read(entry.name, 16);
+		entry.name[15] = 0;
+		entry.packedSize = file->readUint32LE();
+		entry.checksum = file->readUint32LE();
+		entry.offset = file->readUint32LE();
+		entry.size = file->readUint32LE();
+		entry.segment = segment;
+
+		if (entry.offset > fileSize || entry.size > fileSize - entry.offset) {
+			warning("Resource cache %s is corrupt", getSegmentName(segment).c_str());
+			_entries.resize(firstEntry);
+			delete file;
+			return false;
+		}
+
+		_entries.push_back(entry);
+		_totalSize += entry.size;
+	}
+
+	delete file;
+	return true;
+}
+
+int ResourceDiskCache::findEntry(const Common::String &name, uint32 packedSize, uint32 checksum) const {
+	for (uint i = 0; i < _entries.size(); i++) {
+		const Entry &entry = _entries[i];
+		if (entry.packedSize == packedSize && entry.checksum == checksum && name.equalsIgnoreCase(entry.name))
+			return i;
+	}
+
+	return -1;
+}
+
+ResourceBufferPtr ResourceDiskCache::load(const Common::String &name, uint32 packedSize, uint32 checksum) {
+	int index = findEntry(name, packedSize, checksum);
+	if (index < 0)
+		return ResourceBufferPtr();
+
+	const Entry &entry = _entries[index];
+	if (entry.buffer)
+		return entry.buffer;
+
+	Common::SeekableReadStream *file = g_system->getSavefileManager()->openForLoading(getSegmentName(entry.segment));
+	if (!file)
+		return ResourceBufferPtr();
+
+	byte *data = (byte *)malloc(entry.size);
+	file->seek(entry.offset);
+	uint32 readSize = file->read(data, entry.size);
+	delete file;
+
+	if (readSize != entry.size) {
+		free(data);
+		return ResourceBufferPtr();
+	}
+
+	return ResourceBufferPtr(new ResourceBuffer(data, entry.size));
+}
+
+void ResourceDiskCache::store(const Common::String &name, uint32 packedSize, uint32 checksum, const ResourceBufferPtr &buffer) {
+	// Entries for data which has changed since they were written are left in
+	// their segment, as it can't be rewritten in place. They stop matching,
+	// and are dropped along with the rest when the fingerprint changes.
+	if (name.size() > 15 || findEntry(name, packedSize, checksum) >= 0)
+		return;
+
+	if (_segmentCount >= DISK_CACHE_MAX_SEGMENTS || _totalSize + buffer->size > DISK_CACHE_MAX_SIZE)
+		return;
+
+	Entry entry;
+	memset(entry.name, 0, 16);
+	memcpy(entry.name, name.c_str(), name.size());
+	entry.packedSize = packedSize;
+	entry.checksum = checksum;
+	entry.segment = _segmentCount;
+	entry.offset = 0;
+	entry.size = buffer->size;
+	entry.buffer = buffer;
+	_entries.push_back(entry);
+
+	_totalSize += buffer->size;
+	_pendingSize += buffer->size;
+	if (_pendingSize >= DISK_CACHE_BATCH_SIZE)
+		flush();
+}
+
+void ResourceDiskCache::flush() {
+	if (!_pendingSize)
+		return;
+
+	// The pending entries are at the end of the table, and are written to a
+	// new segment, so the existing ones never need to be read back
+	uint firstEntry = _entries.size();
+	while (firstEntry > 0 && _entries[firstEntry - 1].buffer)
+		firstEntry--;
+
+	Common::String segmentName = getSegmentName(_segmentCount);
+
+	// Don't compress the file, so that the data can be read in place
+	Common::OutSaveFile *out = g_system->getSavefileManager()->openForSaving(segmentName, false);
+	if (out) {
+		uint32 count = _entries.size() - firstEntry;
+		out->writeUint32BE(DISK_CACHE_TAG);
+		out->writeUint32LE(DISK_CACHE_VERSION);
+		out->writeUint32LE(_fingerprint);
+		out->writeUint32LE(count);
+
+		uint32 pos = DISK_CACHE_HEADER_SIZE + count * DISK_CACHE_ENTRY_SIZE;
+		uint32 offset = alignOffset(pos);
+
+		for (uint i = firstEntry; i < _entries.size(); i++) {
+			Entry &entry = _entries[i];
+			entry.offset = offset;
+			offset = alignOffset(offset + entry.size);
+
+			out->write(entry.name, 16);
+			out->writeUint32LE(entry.packedSize);
+			out->writeUint32LE(entry.checksum);
+			out->writeUint32LE(entry.offset);
+			out->writeUint32LE(entry.size);
+		}
+
+		static const byte padding[DISK_CACHE_ALIGNMENT] = { 0 };
+		for (uint i = firstEntry; i < _entries.size(); i++) {
+			Entry &entry = _entries[i];
+			out->write(padding, entry.offset - pos);
+			out->write(entry.buffer->data, entry.size);
+			pos = entry.offset + entry.size;
+		}
+
+		out->finalize();
+		if (out->err()) {
+			delete out;
+			out = NULL;
+			g_system->getSavefileManager()->removeSavefile(segmentName);
+		}
+	}
+
+	if (out) {
+		delete out;
+		for (uint i = firstEntry; i < _entries.size(); i++)
+			_entries[i].buffer.reset();
+		_segmentCount++;
+	} else {
+		// Drop the entries rather than keep their data around
+		warning("Could not write resource cache %s", segmentName.c_str());
+		for (uint i = firstEntry; i < _entries.size(); i++)
+			_totalSize -= _entries[i].size;
+		_entries.resize(firstEntry);
+	}
+
+	_pendingSize = 0;
+}
+
+void ResourceDiskCache::clear() {
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	for (uint segment = 0; segment < DISK_CACHE_MAX_SEGMENTS; segment++)
+		saveFileMan->removeSavefile(getSegmentName(segment));
+
+	_entries.clear();
+	_segmentCount = 0;
+	_totalSize = 0;
+	_pendingSize = 0;
+}
+
+} // End of namespace Cryo
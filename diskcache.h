@@ -0,0 +1,97 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_DISKCACHE_H
+#define CRYO_DISKCACHE_H
+
+#include "common/array.h"
+#include "common/str.h"
+
+#include "cryo/resource.h"
+
+namespace Cryo {
+
+/**
+ * Stores unpacked resources in files in the save directory, so that they
+ * don't need to be unpacked again the next time the game is started.
+ *
+ * Resources are identified by their name, packed size and a checksum of
+ * their packed data, so an entry is only used for the exact data it was
+ * unpacked from. All the files are discarded when the fingerprint of the
+ * game data changes.
+ *
+ * Save files can't be appended to, so new entries are written in batches,
+ * each to a segment file of its own, and their data is released once it's
+ * written. The first segment uses the given file name, the following ones
+ * add ".1", ".2" and so on to it.
+ *
+ * Each segment starts with a header and the table of its entries, followed
+ * by the unpacked data of each entry, aligned to 16 bytes:
+ *   uint32 tag, uint32 version, uint32 fingerprint, uint32 entry count
+ *   per entry: char name[16], uint32 packed size, uint32 checksum,
+ *              uint32 offset, uint32 size
+ */
+class ResourceDiskCache {
+public:
+	ResourceDiskCache(const Common::String &fileName, uint32 fingerprint);
+	~ResourceDiskCache();
+
+	ResourceBufferPtr load(const Common::String &name, uint32 packedSize, uint32 checksum);
+	void store(const Common::String &name, uint32 packedSize, uint32 checksum, const ResourceBufferPtr &buffer);
+
+	/**
+	 * Writes the resources which were added since the last flush to a new
+	 * segment
+	 */
+	void flush();
+
+	/**
+	 * Removes all the entries and the files they're stored in
+	 */
+	void clear();
+
+private:
+	struct Entry {
+		char name[16];
+		uint32 packedSize;
+		uint32 checksum;	// of the packed data
+		uint segment;
+		uint32 offset;
+		uint32 size;
+		ResourceBufferPtr buffer;	// set for resources which aren't written yet
+	};
+
+	Common::String getSegmentName(uint segment) const;
+	int findEntry(const Common::String &name, uint32 packedSize, uint32 checksum) const;
+	bool readSegment(uint segment);
+
+	Common::String _fileName;
+	uint32 _fingerprint;
+	Common::Array<Entry> _entries;
+	uint _segmentCount;
+	uint32 _totalSize;
+	uint32 _pendingSize;
+};
+
+} // End of namespace Cryo
+
+#endif
@@ -23,88 +23,303 @@
 #include "common/memstream.h"
 #include "common/system.h"
 
+#include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 
 #include "cryo/resource.h"
+#include "cryo/screen.h"
 #include "cryo/sprite.h"
 #include "cryo/font.h"
 
 namespace Cryo {
 
-#define FIXED_FONT_HEIGHT 9
 // DOS 437 characters start from ASCII 48 ('0')
 // The equivalent ASCII character for '0' in Dune's sprite files is in sprite 15
 #define SPRITE_FONT_OFFSET 33
 #define SPRITE_FONT_SPACE_WIDTH 16
 
-#define SCREEN_WIDTH 320
+Font::Font(CryoEngine *engine) : _engine(engine) {
+}
+
+Font::~Font() {
+	// Another font could be created at the same address
+	if (_engine && _engine->getTextCache())
+		_engine->getTextCache()->invalidate(this);
+}
+
+uint16 Font::getStringWidth(const Common::String &text) const {
+	uint16 width = 0;
+	for (uint i = 0; i < text.size(); i++)
+		width += getCharWidth(text[i]);
+	return width;
+}
 
-FixedFont::FixedFont(Common::String filename, CryoEngine *engine) : _engine(engine) {
+TextLayoutPtr Font::layoutText(const Common::String &text, uint16 maxWidth) {
+	return _layouts.get(*this, text, maxWidth);
+}
+
+FixedFont::FixedFont(Common::String filename, CryoEngine *engine) : Font(engine) {
 	ResourceManager *resMan = _engine->getResourceManager();
-	_stream = resMan->getResource(filename);
-	_stream->read(_charWidth, 256);
+	Common::SeekableReadStream *stream = resMan->getResource(filename);
+
+	// The widths are followed by the rows of all the characters
+	memset(_glyphs, 0, sizeof(_glyphs));
+	stream->read(_charWidth, 256);
+	stream->read(_glyphs, sizeof(_glyphs));
+	delete stream;
+
+	for (uint c = 0; c < 256; c++)
+		_charWidth[c] = MIN<byte>(_charWidth[c], 8);
 }
 
 FixedFont::~FixedFont() {
-	delete _stream;
 }
 
-void FixedFont::drawText(Common::String text, uint16 x, uint16 y, byte color) {
-	uint16 curX = x;
-	char curChar;
-	byte charLine;
-	byte *dest;
+/**
+ * Adds an area which was drawn to, to the total area of a string
+ */
+static void extendDrawnArea(Common::Rect &area, const Common::Rect &drawn) {
+	if (drawn.isEmpty())
+		return;
 
-	Graphics::Surface *screen = _engine->_system->lockScreen();
-	byte *scr = (byte *)screen->getPixels();
+	if (area.isEmpty())
+		area = drawn;
+	else
+		area.extend(drawn);
+}
 
-	for (uint c = 0; c < text.size(); c++) {
-		dest = scr + y * SCREEN_WIDTH + curX;
-		curChar = text[c];
+void Font::drawLayout(const TextLayout &layout, int16 x, int16 y, byte color) {
+	Screen *screen = _engine->getScreen();
+	screen->markDirty(drawLayout(*screen->getSurface(), screen->getClipRect(), layout, x, y, color));
+}
 
-		_stream->seek(256 + curChar * 9);
+Common::Rect Font::drawLayout(Graphics::Surface &surface, const Common::Rect &clip, const TextLayout &layout,
+		int16 x, int16 y, byte color) {
+	Common::Rect area;
 
-		for (uint charY = 0; charY < FIXED_FONT_HEIGHT; charY++) {
-			charLine = _stream->readByte();
+	for (uint i = 0; i < layout.glyphs.size(); i++) {
+		const GlyphPosition &glyph = layout.glyphs[i];
+		extendDrawnArea(area, drawChar(surface, clip, glyph.c, x + glyph.x, y + glyph.y, color));
+	}
 
-			for (uint charX = 0; charX < _charWidth[(uint8)curChar]; charX++) {
-				if (charLine & 0x80)
-					dest[charX] = color;
+	return area;
+}
 
-				charLine <<= 1;
-			}
+void Font::drawCachedText(const Common::String &text, int16 x, int16 y, byte color, uint16 maxWidth) {
+	_engine->getScreen()->drawFrame(*renderText(text, color, maxWidth), x, y);
+}
+
+DecodedFramePtr Font::renderText(const Common::String &text, byte color, uint16 maxWidth) {
+	TextCache *cache = _engine->getTextCache();
+
+	if (!usesColor())
+		color = 0;
+
+	RenderedTextKey key;
+	key.font = this;
+	key.text = text;
+	key.color = color;
+	key.maxWidth = maxWidth;
 
-			dest += SCREEN_WIDTH;
+	DecodedFramePtr rendered = cache->get(key);
+	if (rendered)
+		return rendered;
+
+	TextLayoutPtr layout = layoutText(text, maxWidth);
+	uint16 width = layout->width;
+	uint16 height = layout->height;
+	uint32 size = width * height;
+	rendered = DecodedFramePtr(new DecodedFrame(width, height));
+
+	// The text is drawn over a background of a color the font doesn't draw
+	// with, so the pixels which differ from it are the ones that were drawn
+	byte background = getUnusedColor(color);
+	memset(rendered->pixels, background, size);
+
+	Graphics::Surface surface;
+	surface.init(width, height, width, rendered->pixels, Graphics::PixelFormat::createFormatCLUT8());
+	drawLayout(surface, Common::Rect(width, height), *layout, 0, 0, color);
+
+	// Transparent pixels are 0 in both the pixels and the mask
+	for (uint32 i = 0; i < size; i++) {
+		rendered->mask[i] = (rendered->pixels[i] != background) ? 0xFF : 0;
+		rendered->pixels[i] &= rendered->mask[i];
+	}
+
+	rendered->buildSpans();
+	cache->add(key, rendered);
+	return rendered;
+}
+
+void FixedFont::drawText(Common::String text, int16 x, int16 y, byte color) {
+	Screen *screen = _engine->getScreen();
+	screen->markDirty(drawText(*screen->getSurface(), screen->getClipRect(), text, x, y, color));
+}
+
+Common::Rect FixedFont::drawText(Graphics::Surface &surface, const Common::Rect &clip, Common::String text,
+		int16 x, int16 y, byte color) {
+	Common::Rect surfaceClip = clip;
+	surfaceClip.clip(surface.w, surface.h);
+
+	// The color in all 8 bytes, to be combined with the row masks
+	uint64 colors;
+	memset(&colors, color, sizeof(colors));
+
+	Common::Rect area;
+	int16 curX = x;
+
+	for (uint i = 0; i < text.size(); i++) {
+		byte curChar = text[i];
+		byte width = _charWidth[curChar];
+
+		Common::Rect visible(curX, y, curX + width, y + FIXED_FONT_HEIGHT);
+		visible.clip(surfaceClip);
+
+		if (!visible.isEmpty()) {
+			drawGlyph(&surface, curChar, curX, y, visible, color, colors);
+			extendDrawnArea(area, visible);
 		}
 
-		curX += _charWidth[(uint8)curChar];
+		curX += width;
 	}
 
-	_engine->_system->unlockScreen();
+	return area;
 }
 
-SpriteFont::SpriteFont(Common::String filename, CryoEngine *engine) {
+Common::Rect FixedFont::drawChar(Graphics::Surface &surface, const Common::Rect &clip, byte c,
+		int16 x, int16 y, byte color) {
+	Common::Rect visible(x, y, x + _charWidth[c], y + FIXED_FONT_HEIGHT);
+	visible.clip(clip);
+	visible.clip(surface.w, surface.h);
+	if (visible.isEmpty())
+		return Common::Rect();
+
+	uint64 colors;
+	memset(&colors, color, sizeof(colors));
+	drawGlyph(&surface, c, x, y, visible, color, colors);
+
+	return visible;
+}
+
+/**
+ * Returns, for each row value, 8 bytes which are 0xFF where a pixel is set,
+ * so that a row can be drawn with a single masked write. The table is
+ * shared by all the fixed fonts, and built the first time it's needed.
+ */
+static const byte (*getRowMasks())[8] {
+	static byte rowMasks[256][8];
+	static bool built = false;
+
+	if (!built) {
+		for (uint bits = 0; bits < 256; bits++) {
+			for (uint col = 0; col < 8; col++)
+				rowMasks[bits][col] = (bits & (0x80 >> col)) ? 0xFF : 0;
+		}
+
+		built = true;
+	}
+
+	return rowMasks;
+}
+
+void FixedFont::drawGlyph(Graphics::Surface *surface, byte c, int16 x, int16 y, const Common::Rect &visible,
+		byte color, uint64 colors) {
+	// Only the columns inside of the clip rectangle are drawn
+	byte columns = (0xFF >> (visible.left - x)) & (0xFF << (8 - (visible.right - x)));
+
+	// A row of 8 pixels is written in one go, unless it would go past the
+	// edges of the surface
+	bool wholeRows = (x >= 0 && x + 8 <= surface->w);
+	const byte (*rowMasks)[8] = getRowMasks();
+
+	for (int16 row = visible.top - y; row < visible.bottom - y; row++) {
+		byte bits = _glyphs[c][row] & columns;
+		if (!bits)
+			continue;
+
+		byte *dst = (byte *)surface->getBasePtr(0, y + row);
+
+		if (wholeRows) {
+			uint64 mask, pixels;
+			memcpy(&mask, rowMasks[bits], sizeof(mask));
+			memcpy(&pixels, dst + x, sizeof(pixels));
+			pixels = (pixels & ~mask) | (colors & mask);
+			memcpy(dst + x, &pixels, sizeof(pixels));
+		} else {
+			for (int16 col = visible.left; col < visible.right; col++) {
+				if (bits & (0x80 >> (col - x)))
+					dst[col] = color;
+			}
+		}
+	}
+}
+
+SpriteFont::SpriteFont(Common::String filename, CryoEngine *engine) : Font(engine) {
 	_spr = new Sprite(filename, engine);
+
+	// Measure all the characters up front, so that text can be laid out
+	// without going through the frame headers
+	_height = 0;
+	bool usedColors[256];
+	memset(usedColors, 0, sizeof(usedColors));
+
+	for (uint c = 0; c < 256; c++) {
+		_charWidth[c] = 0;
+		if (c == ' ') {
+			_charWidth[c] = SPRITE_FONT_SPACE_WIDTH;
+		} else if (hasGlyph(c)) {
+			const FrameInfo &info = _spr->getFrameInfo(c - SPRITE_FONT_OFFSET);
+			_charWidth[c] = info.width;
+			_height = MAX<uint16>(_height, info.height);
+
+			// The pixels of a glyph are 4-bit values plus its palette
+			// offset. 0 is transparent in compressed frames.
+			for (uint pixel = info.isCompressed ? 1 : 0; pixel < 16; pixel++)
+				usedColors[(byte)(pixel + info.palOffset)] = true;
+		}
+	}
+
+	_unusedColor = 0;
+	while (_unusedColor < 255 && usedColors[_unusedColor])
+		_unusedColor++;
+
+	if (usedColors[_unusedColor])
+		warning("SpriteFont: The glyphs of %s use all the colors, rendered text will miss some pixels", filename.c_str());
 }
 
 SpriteFont::~SpriteFont() {
 	delete _spr;
 }
 
-void SpriteFont::drawText(Common::String text, uint16 x, uint16 y) {
-	uint16 curX = x;
-	char curChar;
+bool SpriteFont::hasGlyph(byte c) const {
+	return c >= SPRITE_FONT_OFFSET && c - SPRITE_FONT_OFFSET < _spr->getFrameCount();
+}
 
-	for (uint i = 0; i < text.size(); i++) {
-		curChar = text[i];
+void SpriteFont::drawText(Common::String text, int16 x, int16 y) {
+	Screen *screen = _engine->getScreen();
+	screen->markDirty(drawText(*screen->getSurface(), screen->getClipRect(), text, x, y));
+}
 
-		if (curChar == ' ') {
-			curX += SPRITE_FONT_SPACE_WIDTH;
-		} else {
-			_spr->drawFrame(curChar - SPRITE_FONT_OFFSET, curX, y);
-			curX += _spr->getFrameInfo(curChar - SPRITE_FONT_OFFSET).width;
-		}
+Common::Rect SpriteFont::drawText(Graphics::Surface &surface, const Common::Rect &clip, Common::String text,
+		int16 x, int16 y) {
+	Common::Rect area;
+	int16 curX = x;
+
+	for (uint i = 0; i < text.size(); i++) {
+		byte curChar = text[i];
+		extendDrawnArea(area, drawChar(surface, clip, curChar, curX, y, 0));
+		curX += _charWidth[curChar];
 	}
+
+	return area;
+}
+
+Common::Rect SpriteFont::drawChar(Graphics::Surface &surface, const Common::Rect &clip, byte c,
+		int16 x, int16 y, byte color) {
+	if (!hasGlyph(c))
+		return Common::Rect();
+
+	return _spr->drawFrame(surface, clip, c - SPRITE_FONT_OFFSET, x, y);
 }
 
 } // End of namespace Cryo
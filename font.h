@@ -23,37 +23,186 @@
 #ifndef CRYO_FONT_H
 #define CRYO_FONT_H
 
+#include "common/rect.h"
+
+#include "cryo/text.h"
+
+namespace Graphics {
+struct Surface;
+}
+
 namespace Cryo {
 
+class CryoEngine;
 class Resource;
 class Sprite;
 
-class FixedFont {
+#define FIXED_FONT_HEIGHT 9
+
+/**
+ * The measurement and layout functions shared by the game's fonts
+ */
+class Font {
+public:
+	Font(CryoEngine *engine);
+	virtual ~Font();
+
+	virtual uint16 getCharWidth(byte c) const = 0;
+	/** Returns the height of a line of text */
+	virtual uint16 getHeight() const = 0;
+	uint16 getStringWidth(const Common::String &text) const;
+
+	/**
+	 * Word wraps text to the given width. The layouts of recently used
+	 * strings are cached, so calling this on every redraw is cheap.
+	 *
+	 * @param maxWidth            The width of the text box, or 0 to only
+	 *                            break lines at line breaks
+	 */
+	TextLayoutPtr layoutText(const Common::String &text, uint16 maxWidth = 0);
+
+	/**
+	 * Draws laid out text into the engine's back buffer
+	 */
+	void drawLayout(const TextLayout &layout, int16 x, int16 y, byte color);
+
+	/**
+	 * Draws laid out text into any surface, clipped to the given rectangle
+	 *
+	 * @return                    The area of the surface which was drawn to
+	 */
+	Common::Rect drawLayout(Graphics::Surface &surface, const Common::Rect &clip, const TextLayout &layout,
+			int16 x, int16 y, byte color);
+
+	/**
+	 * Draws text into the engine's back buffer, word wrapped to maxWidth.
+	 * The text is rendered once and kept in the engine's text cache, so
+	 * drawing it again on the next frames is a single blit.
+	 */
+	void drawCachedText(const Common::String &text, int16 x, int16 y, byte color, uint16 maxWidth = 0);
+
+	/**
+	 * Renders word wrapped text to 8bpp, going through the engine's text
+	 * cache
+	 */
+	DecodedFramePtr renderText(const Common::String &text, byte color, uint16 maxWidth = 0);
+
+	/**
+	 * Draws a single character, clipped to the given rectangle
+	 *
+	 * @return                    The area of the surface which was drawn to
+	 */
+	virtual Common::Rect drawChar(Graphics::Surface &surface, const Common::Rect &clip, byte c,
+			int16 x, int16 y, byte color) = 0;
+
+protected:
+	/**
+	 * Returns a color which drawChar() doesn't draw with, when it's given
+	 * the color passed in. Text is rendered over it, so that the pixels
+	 * which were drawn can be told apart.
+	 */
+	virtual byte getUnusedColor(byte color) const = 0;
+
+	/**
+	 * Returns whether drawChar() draws with the color it's given. Text in
+	 * fonts which ignore it is cached once for all colors.
+	 */
+	virtual bool usesColor() const = 0;
+
+	CryoEngine *_engine;
+
+private:
+	TextLayoutCache _layouts;
+};
+
+/**
+ * A font with glyphs of 9 rows of up to 8 pixels. The whole font is read
+ * when it's loaded, so drawing text doesn't access the resource.
+ */
+class FixedFont : public Font {
 public:
 	FixedFont(Common::String filename, CryoEngine *engine);
 	~FixedFont();
 
-	void drawText(Common::String text, uint16 x, uint16 y, byte color);
+	uint16 getCharWidth(byte c) const { return _charWidth[c]; }
+	uint16 getHeight() const { return FIXED_FONT_HEIGHT; }
+
+	/**
+	 * Draws text into the engine's back buffer
+	 */
+	void drawText(Common::String text, int16 x, int16 y, byte color);
+
+	/**
+	 * Draws text into any surface, clipped to the given rectangle
+	 *
+	 * @return                    The area of the surface which was drawn to
+	 */
+	Common::Rect drawText(Graphics::Surface &surface, const Common::Rect &clip, Common::String text,
+			int16 x, int16 y, byte color);
+
+	Common::Rect drawChar(Graphics::Surface &surface, const Common::Rect &clip, byte c,
+			int16 x, int16 y, byte color);
+
+protected:
+	// The glyphs are drawn in a single color
+	byte getUnusedColor(byte color) const { return color + 1; }
+	bool usesColor() const { return true; }
 
 private:
-	Common::SeekableReadStream *_stream;
+	void drawGlyph(Graphics::Surface *surface, byte c, int16 x, int16 y, const Common::Rect &visible,
+			byte color, uint64 colors);
+
 	// An array of all the character widths. Each character is
 	// stored as a bit array, so its width can be 0 - 8 pixels
 	byte _charWidth[256];
-	CryoEngine *_engine;
+	// The rows of each character, with the leftmost pixel in the top bit
+	byte _glyphs[256][FIXED_FONT_HEIGHT];
 };
 
-class SpriteFont {
+/**
+ * A font drawn with the frames of a sprite. The glyphs have their own
+ * colors, so the color passed to the layout functions is ignored.
+ */
+class SpriteFont : public Font {
 public:
 	SpriteFont(Common::String filename, CryoEngine *engine);
 	~SpriteFont();
 
-	void drawText(Common::String text, uint16 x, uint16 y);
+	uint16 getCharWidth(byte c) const { return _charWidth[c]; }
+	uint16 getHeight() const { return _height; }
+
+	/**
+	 * Draws text into the engine's back buffer
+	 */
+	void drawText(Common::String text, int16 x, int16 y);
+
+	/**
+	 * Draws text into any surface, clipped to the given rectangle
+	 *
+	 * @return                    The area of the surface which was drawn to
+	 */
+	Common::Rect drawText(Graphics::Surface &surface, const Common::Rect &clip, Common::String text,
+			int16 x, int16 y);
+
+	Common::Rect drawChar(Graphics::Surface &surface, const Common::Rect &clip, byte c,
+			int16 x, int16 y, byte color);
+
+protected:
+	byte getUnusedColor(byte color) const { return _unusedColor; }
+	// The glyphs are drawn in their own colors
+	bool usesColor() const { return false; }
 
 private:
+	bool hasGlyph(byte c) const;
+
 	Sprite *_spr;
+	// The widths of the characters, read from the frame headers at load
+	uint16 _charWidth[256];
+	uint16 _height;
+	// A color none of the glyphs has, found at load
+	byte _unusedColor;
 };
 
 } // End of namespace Cryo
- 
+
 #endif
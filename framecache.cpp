@@ -0,0 +1,152 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "cryo/framecache.h"
+
+namespace Cryo {
+
+DecodedFrame::DecodedFrame(uint16 w, uint16 h, bool isPacked) : width(w), height(h), opaque(false),
+		packed(isPacked), palOffset(0) {
+	if (packed) {
+		pixels = new byte[w * h / 2];
+		mask = 0;
+	} else {
+		pixels = new byte[w * h];
+		mask = new byte[w * h];
+	}
+}
+
+DecodedFrame::~DecodedFrame() {
+	delete[] pixels;
+	delete[] mask;
+}
+
+void DecodedFrame::buildSpans() {
+	if (packed)
+		return;
+
+	spans.clear();
+	rowSpans.resize(height + 1);
+
+	const byte *rowMask = mask;
+	for (uint16 y = 0; y < height; y++) {
+		rowSpans[y] = spans.size();
+
+		uint16 x = 0;
+		while (x < width) {
+			while (x < width && !rowMask[x])
+				x++;
+			if (x == width)
+				break;
+
+			FrameSpan span;
+			span.start = x;
+			while (x < width && rowMask[x])
+				x++;
+			span.length = x - span.start;
+			spans.push_back(span);
+		}
+
+		rowMask += width;
+	}
+
+	rowSpans[height] = spans.size();
+}
+
+FrameCache::FrameCache() : _size(0), _budget(DEFAULT_BUDGET), _hits(0), _misses(0), _evictions(0),
+		_packedFrames(false) {
+}
+
+FrameCache::~FrameCache() {
+}
+
+DecodedFramePtr FrameCache::get(const FrameKey &key) {
+	CacheMap::iterator it = _map.find(key);
+	if (it == _map.end()) {
+		_misses++;
+		return DecodedFramePtr();
+	}
+
+	// Move the frame to the front of the list
+	CacheEntry entry = *it->_value;
+	_list.erase(it->_value);
+	_list.push_front(entry);
+	it->_value = _list.begin();
+
+	_hits++;
+	return entry.frame;
+}
+
+void FrameCache::add(const FrameKey &key, const DecodedFramePtr &frame) {
+	uint32 frameSize = frame->getMemorySize();
+	if (frameSize > _budget || _map.contains(key))
+		return;
+
+	evict(_budget - frameSize);
+
+	CacheEntry entry;
+	entry.key = key;
+	entry.frame = frame;
+	_list.push_front(entry);
+	_map[key] = _list.begin();
+	_size += frameSize;
+}
+
+void FrameCache::evict(uint32 budget) {
+	while (_size > budget && !_list.empty()) {
+		CacheEntry &entry = _list.back();
+		_size -= entry.frame->getMemorySize();
+		_map.erase(entry.key);
+		_list.pop_back();
+		_evictions++;
+	}
+}
+
+void FrameCache::setBudget(uint32 budget) {
+	_budget = budget;
+	evict(_budget);
+}
+
+void FrameCache::clear() {
+	_list.clear();
+	_map.clear();
+	_size = 0;
+}
+
+void FrameCache::setPackedFrames(bool packed) {
+	if (packed != _packedFrames)
+		clear();
+	_packedFrames = packed;
+}
+
+ResourceCacheStats FrameCache::getStats() const {
+	ResourceCacheStats stats;
+	stats.hits = _hits;
+	stats.misses = _misses;
+	stats.evictions = _evictions;
+	stats.entries = _map.size();
+	stats.size = _size;
+	stats.budget = _budget;
+	return stats;
+}
+
+} // End of namespace Cryo
@@ -0,0 +1,162 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_FRAMECACHE_H
+#define CRYO_FRAMECACHE_H
+
+#include "common/array.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/ptr.h"
+#include "common/str.h"
+
+#include "cryo/resource.h"
+
+namespace Cryo {
+
+/**
+ * A run of opaque pixels in a row of a frame
+ */
+struct FrameSpan {
+	uint16 start;
+	uint16 length;
+};
+
+/**
+ * A sprite frame decoded to 8bpp. The mask has one byte per pixel, which is
+ * 0xFF for opaque pixels and 0 for transparent ones.
+ *
+ * The opaque pixels can also be described as a list of spans, so that they
+ * can be drawn with one copy per span instead of a test per pixel. The spans
+ * of row y are spans[rowSpans[y]] to spans[rowSpans[y + 1] - 1].
+ *
+ * Packed frames keep the 4bpp pixels of the sprite file, with the RLE
+ * compression removed, and take a quarter of the memory. The low nibble of
+ * each byte is the first of its two pixels. Pixels are expanded and get
+ * palOffset added while they're drawn. They have no mask: unless the frame
+ * is opaque, 0 pixels are transparent.
+ */
+struct DecodedFrame {
+	DecodedFrame(uint16 w, uint16 h, bool isPacked = false);
+	~DecodedFrame();
+
+	uint16 width;
+	uint16 height;
+	byte *pixels;
+	byte *mask;		// NULL for packed frames
+	bool opaque;	// all of the pixels are opaque
+	bool packed;
+	int8 palOffset;	// only used by packed frames
+
+	Common::Array<FrameSpan> spans;
+	Common::Array<uint32> rowSpans;	// empty until buildSpans() is called
+
+	/**
+	 * Builds the span list from the mask. Packed frames have no spans.
+	 */
+	void buildSpans();
+	bool hasSpans() const { return !rowSpans.empty(); }
+
+	uint32 getMemorySize() const {
+		if (packed)
+			return width * height / 2;
+
+		return width * height * 2 + spans.size() * sizeof(FrameSpan) + rowSpans.size() * sizeof(uint32);
+	}
+};
+
+typedef Common::SharedPtr<DecodedFrame> DecodedFramePtr;
+
+struct FrameKey {
+	Common::String spriteName;
+	uint16 frameIndex;
+	int8 palOffset;
+
+	bool operator==(const FrameKey &key) const {
+		return frameIndex == key.frameIndex && palOffset == key.palOffset &&
+			spriteName.equalsIgnoreCase(key.spriteName);
+	}
+};
+
+struct FrameKey_Hash {
+	uint operator()(const FrameKey &key) const {
+		return Common::hashit_lower(key.spriteName.c_str()) ^ (key.frameIndex << 8) ^ (byte)key.palOffset;
+	}
+};
+
+/**
+ * Keeps recently drawn sprite frames in their decoded form, so that drawing
+ * them again doesn't need to decode them. The least recently used frames are
+ * evicted when the cache grows over its budget.
+ */
+class FrameCache {
+public:
+	enum {
+		DEFAULT_BUDGET = 512 * 1024
+	};
+
+	FrameCache();
+	~FrameCache();
+
+	/**
+	 * Returns the cached frame for the given key, or a NULL pointer if the
+	 * frame is not in the cache
+	 */
+	DecodedFramePtr get(const FrameKey &key);
+	void add(const FrameKey &key, const DecodedFramePtr &frame);
+
+	void setBudget(uint32 budget);
+	void clear();
+	ResourceCacheStats getStats() const;
+
+	/**
+	 * Selects whether frames are cached packed at 4bpp, which saves memory
+	 * but makes drawing slower. Changing it clears the cache.
+	 */
+	void setPackedFrames(bool packed);
+	bool getPackedFrames() const { return _packedFrames; }
+
+private:
+	void evict(uint32 budget);
+
+	struct CacheEntry {
+		FrameKey key;
+		DecodedFramePtr frame;
+	};
+
+	typedef Common::List<CacheEntry> CacheList;
+	typedef Common::HashMap<FrameKey, CacheList::iterator, FrameKey_Hash> CacheMap;
+
+	CacheList _list;	// the most recently used frame is at the front
+	CacheMap _map;
+	uint32 _size;
+	uint32 _budget;
+	uint32 _hits;
+	uint32 _misses;
+	uint32 _evictions;
+	bool _packedFrames;
+};
+
+} // End of namespace Cryo
+
+#endif
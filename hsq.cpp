@@ -21,14 +21,302 @@
  */
 
 #include "common/scummsys.h"
+#include "common/endian.h"
+#include "common/textconsole.h"
+#include "common/util.h"
 
 #include "cryo/hsq.h"
 
 namespace Cryo {
 
-class BitByteReader {
+#define HSQ_PACKED_CHECKSUM 171
+
+HsqReadStream::HsqReadStream(Common::SeekableReadStream *source, DisposeAfterUse::Flag disposeSource)
+	: _source(source),
+	  _disposeSource(disposeSource),
+	  _sourceStart(source->pos()),
+	  _queue(0),
+	  _curBit(0),
+	  _copyCount(0),
+	  _copyDistance(0),
+	  _finished(false),
+	  _historyPos(0),
+	  _pos(0),
+	  _eosFlag(false) {
+	memset(_history, 0, HISTORY_SIZE);
+}
+
+HsqReadStream::~HsqReadStream() {
+	if (_disposeSource == DisposeAfterUse::YES)
+		delete _source;
+}
+
+/* The data is organized in a chunks, 18 and more bytes each.
+ * Every chunk starts with the 2-bytes "header" bitmap, followed
+ * by 16 or more data bytes.
+ * The bits in the bitmap specify how to interpret the respective
+ * data bytes of a chunk. If the subsequent bit in the bitmap is
+ * set (1), then the corresponding data byte is just copied to an
+ * output. If the bitmap bit is zero, then the subsequent bitmap
+ * bits and data bytes are used to locate the sequence in a
+ * previously extracted data and duplicate it. */
+
+byte HsqReadStream::getBit() {
+	if (!_curBit) {
+		_curBit = 16;
+		_queue = _source->readUint16LE();
+	}
+
+	byte result = _queue & 0x1;
+	_queue >>= 1;
+	_curBit--;
+
+	return result;
+}
+
+bool HsqReadStream::decodeToken(byte &destination) {
+	uint16 count;
+	int16 offset;
+
+	if (getBit()) {
+		/* 1 - just copy one byte */
+		destination = _source->readByte();
+		return true;
+	}
+
+	if (getBit()) {
+		/* 10 - copy up to 7 bytes of previously extracted
+		 * data, from no more than 8192 bytes behind the
+		 * current extract position. */
+		byte low = _source->readByte();
+		byte high = _source->readByte();
+
+		count = low & 0x7;
+		offset = ((low >> 3) | (high << 5)) - 8192;
+
+		if (!count) {
+			/* can copy up to 255 bytes */
+			count = _source->readByte();
+		}
+
+		if (!count) {
+			_finished = true;	// finish the unpacking
+			return false;
+		}
+	} else {
+		/* 00 - copy up to 3 bytes from the position not
+		 * further than 256 bytes behind. */
+		count = getBit() * 2;
+		count += getBit();
+		offset = _source->readByte() - 256;
+	}
+
+	if ((uint32)-offset > _pos) {
+		warning("HsqReadStream: Invalid back reference");
+		_finished = true;
+		return false;
+	}
+
+	_copyCount = count + 2;
+	_copyDistance = -offset;
+	return false;
+}
+
+bool HsqReadStream::eos() const {
+	return _eosFlag;
+}
+
+void HsqReadStream::saveState(HsqCheckpoint &checkpoint) const {
+	checkpoint.outputPos = _pos;
+	checkpoint.sourcePos = _source->pos();
+	checkpoint.queue = _queue;
+	checkpoint.curBit = _curBit;
+	checkpoint.copyCount = _copyCount;
+	checkpoint.copyDistance = _copyDistance;
+	checkpoint.finished = _finished;
+	memcpy(checkpoint.history, _history, HISTORY_SIZE);
+	checkpoint.historyPos = _historyPos;
+}
+
+void HsqReadStream::restoreState(const HsqCheckpoint &checkpoint) {
+	_source->seek(checkpoint.sourcePos);
+	_pos = checkpoint.outputPos;
+	_queue = checkpoint.queue;
+	_curBit = checkpoint.curBit;
+	_copyCount = checkpoint.copyCount;
+	_copyDistance = checkpoint.copyDistance;
+	_finished = checkpoint.finished;
+	memcpy(_history, checkpoint.history, HISTORY_SIZE);
+	_historyPos = checkpoint.historyPos;
+	_eosFlag = false;
+}
+
+void HsqReadStream::rewind() {
+	_source->seek(_sourceStart);
+	_pos = 0;
+	_queue = 0;
+	_curBit = 0;
+	_copyCount = 0;
+	_copyDistance = 0;
+	_finished = false;
+	_historyPos = 0;
+	_eosFlag = false;
+}
+
+uint32 HsqReadStream::read(void *dataPtr, uint32 dataSize) {
+	byte *dst = static_cast<byte *>(dataPtr);
+	uint32 bytesRead = 0;
+
+	while (bytesRead < dataSize) {
+		if (_copyCount) {
+			// Continue the current back reference
+			byte value = _history[(_historyPos - _copyDistance) & (HISTORY_SIZE - 1)];
+			putHistory(value);
+			dst[bytesRead++] = value;
+			_copyCount--;
+			_pos++;
+			continue;
+		}
+
+		if (_finished || _source->eos()) {
+			// Flag that we're at EOS
+			_eosFlag = true;
+			break;
+		}
+
+		byte value;
+		if (decodeToken(value)) {
+			putHistory(value);
+			dst[bytesRead++] = value;
+			_pos++;
+		}
+	}
+
+	return bytesRead;
+}
+
+HsqSeekableReadStream::HsqSeekableReadStream(Common::SeekableReadStream *source, uint32 unpackedSize,
+		DisposeAfterUse::Flag disposeSource, uint32 checkpointInterval)
+	: _decoder(source, disposeSource),
+	  _size(unpackedSize),
+	  _pos(0),
+	  _checkpointInterval(checkpointInterval),
+	  _eosFlag(false) {
+	assert(_checkpointInterval > 0);
+	if (_size > 0)
+		_checkpoints.resize((_size - 1) / _checkpointInterval);
+	for (uint i = 0; i < _checkpoints.size(); i++)
+		_checkpoints[i] = NULL;
+}
+
+HsqSeekableReadStream::~HsqSeekableReadStream() {
+	for (uint i = 0; i < _checkpoints.size(); i++)
+		delete _checkpoints[i];
+}
+
+uint32 HsqSeekableReadStream::read(void *dataPtr, uint32 dataSize) {
+	byte *dst = static_cast<byte *>(dataPtr);
+	uint32 bytesRead = 0;
+
+	if (dataSize > _size - _pos) {
+		dataSize = _size - _pos;
+		_eosFlag = true;
+	}
+
+	while (bytesRead < dataSize) {
+		// Stop at the next checkpoint, so that it can be stored on the way
+		uint32 nextCheckpoint = (_pos / _checkpointInterval + 1) * _checkpointInterval;
+		uint32 count = MIN(dataSize - bytesRead, nextCheckpoint - _pos);
+
+		uint32 decoded = _decoder.read(dst + bytesRead, count);
+		bytesRead += decoded;
+		_pos += decoded;
+
+		if (decoded < count) {
+			// The data ended before the size given in the header
+			_size = _pos;
+			_eosFlag = true;
+			break;
+		}
+
+		uint index = _pos / _checkpointInterval;
+		if (_pos == nextCheckpoint && index <= _checkpoints.size() && !_checkpoints[index - 1]) {
+			_checkpoints[index - 1] = new HsqCheckpoint();
+			_decoder.saveState(*_checkpoints[index - 1]);
+		}
+	}
+
+	return bytesRead;
+}
+
+bool HsqSeekableReadStream::seek(int32 offset, int whence) {
+	int32 newPos;
+
+	switch (whence) {
+	case SEEK_END:
+		newPos = _size + offset;
+		break;
+	case SEEK_CUR:
+		newPos = _pos + offset;
+		break;
+	case SEEK_SET:
+	default:
+		newPos = offset;
+		break;
+	}
+
+	if (newPos < 0 || newPos > (int32)_size)
+		return false;
+
+	// Resume from the closest stored checkpoint before the new position,
+	// unless the current position is closer
+	uint index = MIN<uint>(newPos / _checkpointInterval, _checkpoints.size());
+	while (index > 0 && !_checkpoints[index - 1])
+		index--;
+
+	uint32 checkpointPos = index * _checkpointInterval;
+	if ((uint32)newPos < _pos || checkpointPos > _pos) {
+		if (index > 0)
+			_decoder.restoreState(*_checkpoints[index - 1]);
+		else
+			_decoder.rewind();
+		_pos = checkpointPos;
+	}
+
+	skipTo(newPos);
+	_eosFlag = false;
+	return true;
+}
+
+void HsqSeekableReadStream::skipTo(uint32 position) {
+	byte buffer[1024];
+
+	while (_pos < position) {
+		uint32 count = MIN<uint32>(position - _pos, sizeof(buffer));
+		if (read(buffer, count) < count)
+			break;
+	}
+}
+
+bool parseHsqHeader(const byte *header, uint16 &unpackedSize, uint16 &packedSize) {
+	byte sum = 0;	// sum must be a byte, so that the salt value can overflow it to 0xAB
+	for (int i = 0; i < 6; i++)
+		sum += header[i];
+
+	if (sum != HSQ_PACKED_CHECKSUM)
+		return false;
+
+	unpackedSize = READ_LE_UINT16(header);
+	assert(header[2] == 0);
+	packedSize = READ_LE_UINT16(header + 3);
+	// header[5] is the salt byte for the checksum
+
+	return true;
+}
+
+class BufferBitReader {
 public:
-	BitByteReader(Common::SeekableReadStream *data) : _data(data), _curBit(0), _queue(0) { }
+	BufferBitReader(const byte *data, uint32 size) : _data(data), _end(data + size), _curBit(0), _queue(0) { }
 
 	byte getBit() {
 		if (!_curBit)
@@ -42,80 +330,104 @@ public:
 	}
 
 	byte getByte() {
-		return _data->readByte();
+		return (_data < _end) ? *_data++ : 0;
+	}
+
+	/**
+	 * Consumes all the consecutive literal (1) bits left in the queue, and
+	 * returns their count. The bit that stopped the run is not consumed.
+	 */
+	uint getLiteralRun() {
+		if (!_curBit)
+			refillQueue();
+
+		uint count = 0;
+		while (count < _curBit && (_queue & (1 << count)))
+			count++;
+
+		_queue >>= count;
+		_curBit -= count;
+
+		return count;
 	}
 
+	const byte *getData() const { return _data; }
+	uint32 bytesLeft() const { return _end - _data; }
+	void skip(uint32 count) { _data += count; }
+
 private:
 	void refillQueue() {
 		_curBit = 16;
-		_queue = _data->readUint16LE();
+		if (_end - _data >= 2) {
+			_queue = READ_LE_UINT16(_data);
+			_data += 2;
+		} else {
+			_queue = getByte();
+		}
 	}
 
-	Common::SeekableReadStream *_data;
-	byte _curBit;
-	uint16 _queue;
+	const byte *_data;
+	const byte *_end;
+	uint _curBit;
+	uint32 _queue;
 };
 
+uint32 decompressHsq(const byte *source, uint32 sourceSize, byte *destination, uint32 destinationSize) {
+	BufferBitReader br(source, sourceSize);
+	byte *dst = destination;
+	byte *dstEnd = destination + destinationSize;
+	uint count;
+	int offset;
 
-HsqReadStream::HsqReadStream(Common::SeekableReadStream *source)
-	: _source(source),
-	  // It's convention to set the starting cursor position to blockSize - 16
-	  _windowCursor(0x0FEE),
-	  _eosFlag(false) {
-	// All values up to _windowCursor inits by 0x20
-	memset(_window, 0x20, _windowCursor);
-	memset(_window + _windowCursor, 0, BLOCK_SIZE - _windowCursor);
-}
+	while (true) {
+		uint literals = br.getLiteralRun();
+		if (literals) {
+			// A run of 1 bits is a run of bytes that are copied as-is
+			if (literals > br.bytesLeft() || literals > (uint)(dstEnd - dst)) {
+				warning("decompressHsq: Literal run overflows the buffers");
+				break;
+			}
 
-/* The data is organized in a chunks, 18 and more bytes each.
- * Every chunk starts with the 2-bytes "header" bitmap, followed
- * by 16 or more data bytes.
- * The bits in the bitmap specify how to interpret the respective
- * data bytes of a chunk. If the subsequent bit in the bitmap is
- * set (1), then the corresponding data byte is just copied to an
- * output. If the bitmap bit is zero, then the subsequent bitmap
- * bits and data bytes are used to locate the sequence in a
- * previously extracted data and duplicate it. */
+			memcpy(dst, br.getData(), literals);
+			br.skip(literals);
+			dst += literals;
+			continue;
+		}
 
-uint32 HsqReadStream::decompressBytes(byte *destination, uint32 numberOfBytes) {
-	uint16 count;
-	int16 offset;
-	BitByteReader br(_source);
-	byte *dst = destination;
+		br.getBit();	// the 0 bit that ended the literal run
 
-	while (true) {
 		if (br.getBit()) {
-			/* 1 - just copy one byte */
-			*dst++ = br.getByte();
+			byte low = br.getByte();
+			byte high = br.getByte();
+
+			count = low & 0x7;
+			offset = ((low >> 3) | (high << 5)) - 8192;
+
+			if (!count)
+				count = br.getByte();
+
+			if (!count)
+				break;	// finish the unpacking
 		} else {
-			if (br.getBit()) {
-				/* 10 - copy up to 7 bytes of previously extracted
-				 * data, from no more than 8192 bytes behind the
-				 * current extract position. */
-				byte low = br.getByte();
-				byte high = br.getByte();
-
-				count = low & 0x7;
-				offset = ((low >> 3) | (high << 5)) - 8192;
-
-				if (!count) {
-					/* can copy up to 255 bytes */
-					count = br.getByte();
-				}
-							
-				if (!count)
-					break;	// finish the unpacking
-			} else {
-				/* 00 - copy up to 3 bytes from the position not
-				 * further than 256 bytes behind. */
-				count = br.getBit() * 2;
-				count += br.getBit();
-				offset = br.getByte() - 256;
-			}
+			count = br.getBit() * 2;
+			count += br.getBit();
+			offset = br.getByte() - 256;
+		}
 
-			count += 2;
+		count += 2;
 
-			byte *src = dst + offset;
+		if (dst + offset < destination || count > (uint)(dstEnd - dst)) {
+			warning("decompressHsq: Invalid back reference");
+			break;
+		}
+
+		byte *src = dst + offset;
+		if (count <= (uint)-offset) {
+			// The source and destination don't overlap, so copy the whole block
+			memcpy(dst, src, count);
+			dst += count;
+		} else {
+			// Overlapping copies repeat the last bytes, so go one at a time
 			while (count--)
 				*dst++ = *src++;
 		}
@@ -124,18 +436,4 @@ uint32 HsqReadStream::decompressBytes(byte *destination, uint32 numberOfBytes) {
 	return dst - destination;
 }
 
-bool HsqReadStream::eos() const {
-	return _eosFlag;
-}
-
-uint32 HsqReadStream::read(void *dataPtr, uint32 dataSize) {
-	uint32 bytesRead = decompressBytes(static_cast<byte *>(dataPtr), dataSize);
-	if (bytesRead < dataSize) {
-		// Flag that we're at EOS
-		_eosFlag = true;
-	}
-
-	return bytesRead;
-}
-
 } // End of namespace Cryo
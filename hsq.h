@@ -23,8 +23,9 @@
 #ifndef CRYO_HSQ_STREAM_H
 #define CRYO_HSQ_STREAM_H
 
-#include "common/stream.h"
 #include "common/array.h"
+#include "common/stream.h"
+#include "common/types.h"
 
 namespace Common {
 class SeekableReadStream;
@@ -32,25 +33,70 @@ class SeekableReadStream;
 
 namespace Cryo {
 
+/**
+ * A snapshot of the HSQ decoder state, from which decoding can be resumed
+ */
+struct HsqCheckpoint {
+	enum {
+		HISTORY_SIZE = 0x2000	// back references reach up to 8192 bytes behind
+	};
+
+	uint32 outputPos;
+	uint32 sourcePos;
+	uint16 queue;
+	byte curBit;
+	uint16 copyCount;
+	uint16 copyDistance;
+	bool finished;
+	byte history[HISTORY_SIZE];
+	uint16 historyPos;
+};
+
 class HsqReadStream : public Common::ReadStream {
 public:
 	/**
 	 * A class that decompresses HSQ data and implements ReadStream for easy access
-	 * to the decompiled data.
+	 * to the decompiled data. Data is decompressed on demand, so only the last
+	 * 8KB of output (the furthest a back reference can reach) is kept in memory.
 	 *
-	 * @param source              The source data
+	 * @param source              The source data, positioned after the HSQ header
+	 * @param disposeSource       Whether to delete the source stream along with this one
+	 */
+	HsqReadStream(Common::SeekableReadStream *source, DisposeAfterUse::Flag disposeSource = DisposeAfterUse::NO);
+	~HsqReadStream();
+
+	/**
+	 * Stores the current decoder state, so that decoding can be resumed from
+	 * this point with restoreState()
 	 */
-	HsqReadStream(Common::SeekableReadStream *source);
+	void saveState(HsqCheckpoint &checkpoint) const;
+	void restoreState(const HsqCheckpoint &checkpoint);
+
+	/**
+	 * Restarts decoding from the beginning of the source data
+	 */
+	void rewind();
 
 private:
 	enum {
-		BLOCK_SIZE = 0x1000
+		HISTORY_SIZE = HsqCheckpoint::HISTORY_SIZE
 	};
 
 private:
 	Common::SeekableReadStream *_source;
-	byte _window[BLOCK_SIZE];
-	uint _windowCursor;
+	DisposeAfterUse::Flag _disposeSource;
+	uint32 _sourceStart;
+
+	// The state of the decoder, kept between reads
+	uint16 _queue;
+	byte _curBit;
+	uint16 _copyCount;		// bytes still to be copied from the current back reference
+	uint16 _copyDistance;	// how far behind the output position the back reference starts
+	bool _finished;			// the end marker has been reached
+
+	byte _history[HISTORY_SIZE];
+	uint16 _historyPos;
+	uint32 _pos;
 	bool _eosFlag;
 
 public:
@@ -58,14 +104,95 @@ public:
 	uint32 read(void *dataPtr, uint32 dataSize);
 
 private:
+	byte getBit();
+
 	/**
-	 * Decompress the next <numberOfBytes> from the source stream. Or until EOS
-	 *
-	 * @param numberOfBytes    How many bytes to decompress. This is a count of source bytes, not destination bytes
+	 * Decodes the next token of the source stream. A literal byte is written
+	 * to destination and true is returned. A back reference only sets up
+	 * _copyCount and _copyDistance, and false is returned.
+	 */
+	bool decodeToken(byte &destination);
+
+	void putHistory(byte value) {
+		_history[_historyPos] = value;
+		_historyPos = (_historyPos + 1) & (HISTORY_SIZE - 1);
+	}
+};
+
+/**
+ * A seekable stream over HSQ data. Like HsqReadStream, only a small part of
+ * the unpacked data is kept in memory. Every <checkpointInterval> bytes of
+ * output, the decoder state is stored the first time it's reached, so that
+ * seeking only needs to decode from the closest checkpoint before the new
+ * position.
+ */
+class HsqSeekableReadStream : public Common::SeekableReadStream {
+public:
+	enum {
+		DEFAULT_CHECKPOINT_INTERVAL = 0x4000
+	};
+
+	/**
+	 * @param source              The source data, positioned after the HSQ header
+	 * @param unpackedSize        The unpacked size, as stored in the HSQ header
+	 * @param disposeSource       Whether to delete the source stream along with this one
+	 * @param checkpointInterval  How many bytes of output are between two checkpoints
+	 */
+	HsqSeekableReadStream(Common::SeekableReadStream *source, uint32 unpackedSize,
+			DisposeAfterUse::Flag disposeSource = DisposeAfterUse::NO,
+			uint32 checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL);
+	~HsqSeekableReadStream();
+
+	bool eos() const { return _eosFlag; }
+	void clearErr() { _eosFlag = false; }
+	uint32 read(void *dataPtr, uint32 dataSize);
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+	bool seek(int32 offset, int whence = SEEK_SET);
+
+private:
+	/**
+	 * Decodes and throws away data until the given position is reached
 	 */
-	uint32 decompressBytes(byte *destination, uint32 numberOfBytes);
+	void skipTo(uint32 position);
+
+	HsqReadStream _decoder;
+	uint32 _size;
+	uint32 _pos;
+	uint32 _checkpointInterval;
+	bool _eosFlag;
+
+	// The checkpoint at index i is at output position (i + 1) * _checkpointInterval,
+	// and is NULL until decoding has reached that position
+	Common::Array<HsqCheckpoint *> _checkpoints;
 };
 
+/**
+ * Checks if the given 6 byte header is the header of HSQ packed data, and
+ * reads the sizes stored in it
+ *
+ * @param header              The first 6 bytes of the data
+ * @param unpackedSize        Receives the size of the unpacked data
+ * @param packedSize          Receives the size of the packed data, including the header
+ * @return                    Whether the data is packed
+ */
+bool parseHsqHeader(const byte *header, uint16 &unpackedSize, uint16 &packedSize);
+
+/**
+ * Decompresses HSQ data which has already been read into memory in one go.
+ * This produces the same output as HsqReadStream, but avoids the per byte
+ * stream overhead, so it should be preferred when the whole packed member
+ * is available.
+ *
+ * @param source              The packed data, without the 6 byte HSQ header
+ * @param sourceSize          The size of the packed data
+ * @param destination         The buffer that receives the unpacked data
+ * @param destinationSize     The size of the destination buffer
+ * @return                    The number of bytes written to destination
+ */
+uint32 decompressHsq(const byte *source, uint32 sourceSize, byte *destination, uint32 destinationSize);
+
 }
 
 #endif
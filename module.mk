@@ -1,14 +1,21 @@
 MODULE := engines/cryo
  
 MODULE_OBJS := \
+	benchmark.o \
+	blit.o \
 	console.o \
 	detection.o \
+	diskcache.o \
 	cryo.o \
 	font.o \
+	framecache.o \
 	music.o \
+	palette.o \
 	resource.o \
+	screen.o \
 	sentences.o \
 	sprite.o \
+	text.o \
 	hsq.o
 	
 MODULE_DIRS += \
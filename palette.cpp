@@ -0,0 +1,104 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/system.h"
+
+#include "graphics/palette.h"
+
+#include "cryo/palette.h"
+
+namespace Cryo {
+
+Palette::Palette(OSystem *system) : _system(system), _dirtyStart(PALETTE_COLORS), _dirtyEnd(0), _fadeSteps(0) {
+	memset(_colors, 0, sizeof(_colors));
+}
+
+Palette::~Palette() {
+}
+
+void Palette::markDirty(uint start, uint end) {
+	_dirtyStart = MIN(_dirtyStart, start);
+	_dirtyEnd = MAX(_dirtyEnd, end);
+}
+
+void Palette::setColors(const byte *colors, uint start, uint count) {
+	assert(start + count <= PALETTE_COLORS);
+	memcpy(_colors + start * 3, colors, count * 3);
+	markDirty(start, start + count);
+}
+
+void Palette::fadeTo(const byte *target, uint steps) {
+	if (steps == 0) {
+		setColors(target, 0, PALETTE_COLORS);
+		_fadeSteps = 0;
+		return;
+	}
+
+	memcpy(_fadeTarget, target, PALETTE_SIZE);
+
+	for (uint i = 0; i < PALETTE_SIZE; i++) {
+		_fadeCurrent[i] = _colors[i] << 8;
+		_fadeIncrement[i] = (target[i] - _colors[i]) * 256 / (int)steps;
+	}
+
+	_fadeSteps = steps;
+}
+
+void Palette::fadeIn(const byte *target, uint steps) {
+	memset(_colors, 0, PALETTE_SIZE);
+	markDirty(0, PALETTE_COLORS);
+	fadeTo(target, steps);
+}
+
+void Palette::fadeOut(uint steps) {
+	byte black[PALETTE_SIZE];
+	memset(black, 0, PALETTE_SIZE);
+	fadeTo(black, steps);
+}
+
+void Palette::update() {
+	if (_fadeSteps > 0) {
+		_fadeSteps--;
+
+		// The last step lands exactly on the target, whatever the rounding
+		// of the increments was
+		if (_fadeSteps == 0) {
+			memcpy(_colors, _fadeTarget, PALETTE_SIZE);
+		} else {
+			for (uint i = 0; i < PALETTE_SIZE; i++) {
+				_fadeCurrent[i] += _fadeIncrement[i];
+				_colors[i] = _fadeCurrent[i] >> 8;
+			}
+		}
+
+		markDirty(0, PALETTE_COLORS);
+	}
+
+	if (_dirtyStart >= _dirtyEnd)
+		return;
+
+	_system->getPaletteManager()->setPalette(_colors + _dirtyStart * 3, _dirtyStart, _dirtyEnd - _dirtyStart);
+	_dirtyStart = PALETTE_COLORS;
+	_dirtyEnd = 0;
+}
+
+} // End of namespace Cryo
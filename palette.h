@@ -0,0 +1,95 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_PALETTE_H
+#define CRYO_PALETTE_H
+
+#include "common/scummsys.h"
+
+class OSystem;
+
+namespace Cryo {
+
+#define PALETTE_COLORS 256
+#define PALETTE_SIZE (PALETTE_COLORS * 3)
+
+/**
+ * The engine's palette. Colors are changed in a resident RGB table, and the
+ * changed part of it is sent to the backend in a single call by update(),
+ * once per frame. Fades are spread over a number of frames, and advance by
+ * one step on every update.
+ */
+class Palette {
+public:
+	Palette(OSystem *system);
+	~Palette();
+
+	/**
+	 * Changes count colors of the palette, starting at start. The colors
+	 * are 8-bit RGB triplets.
+	 */
+	void setColors(const byte *colors, uint start, uint count);
+	const byte *getColors() const { return _colors; }
+
+	/**
+	 * Fades from the current colors to the given palette
+	 */
+	void fadeTo(const byte *target, uint steps);
+
+	/**
+	 * Fades from black to the given palette
+	 */
+	void fadeIn(const byte *target, uint steps);
+
+	/**
+	 * Fades from the current colors to black
+	 */
+	void fadeOut(uint steps);
+
+	bool isFading() const { return _fadeSteps > 0; }
+
+	/**
+	 * Advances the current fade, and sends the colors which have changed
+	 * since the last update to the backend
+	 */
+	void update();
+
+private:
+	void markDirty(uint start, uint end);
+
+	OSystem *_system;
+
+	byte _colors[PALETTE_SIZE];
+	uint _dirtyStart;	// the range of colors changed since the last update
+	uint _dirtyEnd;
+
+	// Fades are computed in 8.8 fixed point. The increments of each color
+	// component are computed once when a fade starts.
+	byte _fadeTarget[PALETTE_SIZE];
+	uint16 _fadeCurrent[PALETTE_SIZE];
+	int16 _fadeIncrement[PALETTE_SIZE];
+	uint _fadeSteps;	// steps left in the current fade
+};
+
+} // End of namespace Cryo
+
+#endif
@@ -20,61 +20,114 @@
  *
  */
 
+#include "common/endian.h"
 #include "common/file.h"
 #include "common/debug.h"
 #include "common/substream.h"
+#include "common/system.h"
+#include "common/algorithm.h"
 #include "common/archive.h"
+#include "common/hash-str.h"
 
+#include "cryo/diskcache.h"
 #include "cryo/resource.h"
 #include "cryo/hsq.h"
 
 namespace Cryo {
 
-#define HSQ_PACKED_CHECKSUM 171
+#define DAT_DIRECTORY_ENTRY_SIZE 25
+#define DEFAULT_CACHE_BUDGET (2 * 1024 * 1024)
+// The number of resources which dumpResources() loads at a time
+#define DUMP_BATCH_SIZE 16
 
-DatArchive::DatArchive(const Common::String &filename) : _datFilename(filename) {
-	Common::File datFile;
+static bool compareDatEntries(const DatArchive::DatEntry &a, const DatArchive::DatEntry &b) {
+	return a.hash < b.hash;
+}
+
+static uint32 checksumData(const byte *data, uint32 size, uint32 checksum = 2166136261u) {
+	// FNV-1a
+	for (uint32 i = 0; i < size; i++)
+		checksum = (checksum ^ data[i]) * 16777619u;
+
+	return checksum;
+}
+
+DatArchive::DatArchive(const Common::String &filename) : _datFilename(filename), _stream(NULL), _fingerprint(0) {
+	// The archive is opened once, and all the member streams read from it
+	Common::File *datFile = new Common::File();
 
-	if (!datFile.open(_datFilename)) {
+	if (!datFile->open(_datFilename)) {
 		warning("DatArchive::DatArchive(): Could not find archive file %s", _datFilename.c_str());
+		delete datFile;
 		return;
 	}
 
-	uint16 entries = datFile.readUint16LE();
+	_stream = datFile;
 
-	DatEntry entry;
-	DatEntry *entr;
+	// Each directory entry is a 16 byte file name, the size, the offset and
+	// an unused byte. Read the whole directory at once.
+	uint16 entries = _stream->readUint16LE();
+	uint32 directorySize = entries * DAT_DIRECTORY_ENTRY_SIZE;
+	byte *directory = new byte[directorySize];
+	_stream->read(directory, directorySize);
+	_fingerprint = checksumData(directory, directorySize, _stream->size());
+
+	_files.reserve(entries);
 
 	for (uint16 i = 0; i < entries; i++) {
-		datFile.read(&entry.filename, 16);
+		const byte *cur = directory + i * DAT_DIRECTORY_ENTRY_SIZE;
+		if (!cur[0])
+			continue;	// unused entry
+
+		DatEntry entry;
+		memcpy(entry.filename, cur, 16);
+		entry.filename[15] = 0;
+		entry.size = READ_LE_UINT32(cur + 16);
+		entry.offset = READ_LE_UINT32(cur + 20);
+		entry.hash = Common::hashit_lower(entry.filename);
+		_files.push_back(entry);
+	}
 
-		entry.size = datFile.readUint32LE();
-		entry.offset = datFile.readUint32LE();
+	delete[] directory;
 
-		entr = new DatEntry(entry);
+	Common::sort(_files.begin(), _files.end(), compareDatEntries);
+}
 
-		_files[entry.filename] = entr;
+DatArchive::~DatArchive() {
+	delete _stream;
+}
 
-		datFile.readByte();
-		//if (_fileTable[i].offset != 0)
-		//	debug("Entry %d: name: %s size: %d offset: %d", i, _fileTable[i].fileName, _fileTable[i].size, _fileTable[i].offset);
+const DatArchive::DatEntry *DatArchive::findEntry(const Common::String &name) const {
+	uint32 hash = Common::hashit_lower(name.c_str());
+
+	// Binary search for the first entry with this hash
+	uint first = 0;
+	uint last = _files.size();
+	while (first < last) {
+		uint mid = (first + last) / 2;
+		if (_files[mid].hash < hash)
+			first = mid + 1;
+		else
+			last = mid;
 	}
+
+	for (uint i = first; i < _files.size() && _files[i].hash == hash; i++) {
+		if (!scumm_stricmp(_files[i].filename, name.c_str()))
+			return &_files[i];
+	}
+
+	return NULL;
 }
 
 bool DatArchive::hasFile(const Common::String &name) const {
-	return _files.contains(name);
+	return findEntry(name) != NULL;
 }
 
 int DatArchive::listMembers(Common::ArchiveMemberList &list) const {
-	int matches = 0;
-
-	FileMap::const_iterator it = _files.begin();
-	for ( ; it != _files.end(); ++it) {
-		list.push_back(Common::ArchiveMemberList::value_type(new Common::GenericArchiveMember(it->_value->filename, this)));
-		matches++;
-	}
+	for (uint i = 0; i < _files.size(); i++)
+		list.push_back(Common::ArchiveMemberList::value_type(new Common::GenericArchiveMember(_files[i].filename, this)));
 
-	return matches;
+	return _files.size();
 }
 
 const Common::ArchiveMemberPtr DatArchive::getMember(const Common::String &name) const {
@@ -85,19 +138,19 @@ const Common::ArchiveMemberPtr DatArchive::getMember(const Common::String &name)
 }
 
 Common::SeekableReadStream *DatArchive::createReadStreamForMember(const Common::String &name) const {
-	if (!_files.contains(name)) {
+	const DatEntry *entry = findEntry(name);
+	if (!_stream || !entry) {
 		return 0;
 	}
 
-	DatEntry *entry = _files[name];
-
-	Common::File *archive = new Common::File();
-	if (!archive->open(_datFilename)) {
-		delete archive;
-		return NULL;
-	}
+	// Members are views on the shared archive stream, which seek it to their
+	// own position before each read
+	return new Common::SafeSeekableSubReadStream(_stream, entry->offset, entry->offset + entry->size, DisposeAfterUse::NO);
+}
 
-	return new Common::SeekableSubReadStream(archive, entry->offset, entry->offset + entry->size, DisposeAfterUse::YES);
+uint32 DatArchive::getMemberOffset(const Common::String &name) const {
+	const DatEntry *entry = findEntry(name);
+	return entry ? entry->offset : 0;
 }
 
 Common::Archive *makeDatArchive(const Common::String &name) {
@@ -105,7 +158,9 @@ Common::Archive *makeDatArchive(const Common::String &name) {
 }
 
 
-ResourceManager::ResourceManager(bool isCD) : _isCD(isCD) {
+ResourceManager::ResourceManager(bool isCD) : _isCD(isCD), _streamingThreshold(0),
+	_cacheSize(0), _cacheBudget(DEFAULT_CACHE_BUDGET), _cacheHits(0), _cacheMisses(0), _cacheEvictions(0),
+	_diskCache(NULL) {
 	if (_isCD) {
 		_archive = (DatArchive *)makeDatArchive("DUNE.DAT");
 	} else {
@@ -114,71 +169,431 @@ ResourceManager::ResourceManager(bool isCD) : _isCD(isCD) {
 }
 
 ResourceManager::~ResourceManager() {
+	delete _diskCache;
+	clearCache();
 	delete _archive;
 }
 
-Common::SeekableReadStream *ResourceManager::getResource(Common::String fileName) {
+Common::SeekableReadStream *ResourceManager::openResource(const Common::String &fileName) {
 	Common::SeekableReadStream *rsrc = NULL;
-	Common::SeekableReadStream *res = NULL;
 
 	if (_isCD) {
 		rsrc = _archive->createReadStreamForMember(fileName);
 	} else {
-		Common::File* file = new Common::File();
-		file->open(fileName);
-		rsrc = file;
+		Common::File *file = new Common::File();
+		if (file->open(fileName))
+			rsrc = file;
+		else
+			delete file;
 	}
 
 	if (!rsrc)
 		error("Could not get file %s", fileName.c_str());
 
-	byte sum = 0;	// sum must be a byte, so that the salt value can overflow it to 0xAB
-	for (int i = 0; i < 6; i++)
-		sum += rsrc->readByte();
+	return rsrc;
+}
+
+bool ResourceManager::readHsqHeader(Common::SeekableReadStream *rsrc, const Common::String &fileName, uint16 &unpackedSize) {
+	byte header[6];
+	uint16 packedSize;
+
+	if (rsrc->read(header, 6) != 6 || !parseHsqHeader(header, unpackedSize, packedSize)) {
+		rsrc->seek(0);
+		return false;
+	}
+
+	if (packedSize != rsrc->size())
+		error("File %s is corrupt - size is %d, it should be %d", fileName.c_str(), rsrc->size(), packedSize);
+
+	return true;
+}
+
+bool ResourceManager::hasResource(const Common::String &fileName) const {
+	if (_isCD)
+		return _archive->hasFile(fileName);
+	else
+		return Common::File::exists(fileName);
+}
+
+Common::SeekableReadStream *ResourceManager::getRawResource(Common::String fileName) {
+	return openResource(fileName);
+}
+
+Common::SeekableReadStream *ResourceManager::getResource(Common::String fileName) {
+	ResourceBufferPtr buffer = getCachedResource(fileName);
+	if (buffer)
+		return new ResourceReadStream(buffer);
 
-	rsrc->seek(0);
+	return unpackResource(openResource(fileName), fileName, NULL);
+}
 
-	if (sum == HSQ_PACKED_CHECKSUM) {
-		uint16 unpackedSize = rsrc->readUint16LE();
-		assert (rsrc->readByte() == 0);
-		uint16 packedSize = rsrc->readUint16LE();
-		rsrc->readByte(); // Salt byte for checksum
+Common::SeekableReadStream *ResourceManager::unpackResource(Common::SeekableReadStream *rsrc, const Common::String &fileName, byte *packedData) {
+	uint16 unpackedSize;
 
-		if (packedSize != rsrc->size())
-			error("File %s is corrupt - size is %d, it should be %d", fileName.c_str(), rsrc->size(), packedSize);
+	ResourceBufferPtr resource;
 
-		byte *unpackData = new byte[unpackedSize];
+	if (readHsqHeader(rsrc, fileName, unpackedSize)) {
+		// Large resources can be unpacked on demand, trading some speed for memory
+		if (_streamingThreshold && unpackedSize >= _streamingThreshold)
+			return new HsqSeekableReadStream(rsrc, unpackedSize, DisposeAfterUse::YES);
 
-		HsqReadStream hsqStream(rsrc);
-		uint32 unpacked = hsqStream.read(unpackData, unpackedSize);
-		res = new Common::MemoryReadStream(unpackData, unpacked, DisposeAfterUse::YES);
+		resource = unpackHsq(rsrc, fileName, unpackedSize, packedData);
 	} else {
-		rsrc->seek(0);
-		res = rsrc;
+		// Members which aren't packed are cached as well, so that they aren't
+		// read again on every request. Large ones are read from the file.
+		if (_streamingThreshold && (uint32)rsrc->size() >= _streamingThreshold)
+			return rsrc;
+
+		resource = readRawResource(rsrc);
 	}
 
-	return res;
+	addCachedResource(fileName, resource);
+
+	return new ResourceReadStream(resource);
 }
 
-bool ResourceManager::dumpResource(Common::String fileName) {
-	Common::SeekableReadStream *rsrc = getResource(fileName);
-	uint16 size = rsrc->size();
+ResourceBufferPtr ResourceManager::unpackHsq(Common::SeekableReadStream *rsrc, const Common::String &fileName, uint16 unpackedSize, byte *packedData) {
+	uint32 packedSize = rsrc->size() - 6;
+
+	// Read the whole member in one go, and unpack it from memory. The packed
+	// size is a 16-bit value, so callers can pass a 64KB buffer to reuse
+	byte *buffer = packedData ? packedData : new byte[packedSize];
+	rsrc->read(buffer, packedSize);
+	delete rsrc;
+
+	// Disk cache entries are checked against the packed data, which is much
+	// cheaper to read than to unpack
+	uint32 checksum = _diskCache ? checksumData(buffer, packedSize) : 0;
+	ResourceBufferPtr resource;
+	if (_diskCache)
+		resource = _diskCache->load(fileName, packedSize, checksum);
+
+	if (!resource) {
+		byte *unpackData = (byte *)malloc(unpackedSize);
+		uint32 unpacked = decompressHsq(buffer, packedSize, unpackData, unpackedSize);
+		resource = ResourceBufferPtr(new ResourceBuffer(unpackData, unpacked));
+
+		if (_diskCache)
+			_diskCache->store(fileName, packedSize, checksum, resource);
+	}
+
+	if (!packedData)
+		delete[] buffer;
 
-	byte *data = new byte[size];
+	return resource;
+}
 
+ResourceBufferPtr ResourceManager::readRawResource(Common::SeekableReadStream *rsrc) {
+	uint32 size = rsrc->size();
+	byte *data = (byte *)malloc(size);
 	rsrc->read(data, size);
+	delete rsrc;
+
+	return ResourceBufferPtr(new ResourceBuffer(data, size));
+}
+
+ResourceBufferPtr ResourceManager::loadResourceBuffer(const Common::String &fileName) {
+	ResourceBufferPtr resource = getCachedResource(fileName);
+	if (resource)
+		return resource;
+
+	Common::SeekableReadStream *rsrc = openResource(fileName);
+	uint16 unpackedSize;
+
+	if (readHsqHeader(rsrc, fileName, unpackedSize))
+		resource = unpackHsq(rsrc, fileName, unpackedSize, NULL);
+	else
+		resource = readRawResource(rsrc);
+
+	addCachedResource(fileName, resource);
+	return resource;
+}
+
+ResourceRequestPtr ResourceManager::requestAsync(const Common::String &fileName, ResourcePriority priority) {
+	// Resources which are already requested just get their priority raised
+	for (RequestList::iterator it = _requests.begin(); it != _requests.end(); ++it) {
+		if ((*it)->_fileName.equalsIgnoreCase(fileName)) {
+			ResourceRequestPtr request = *it;
+			if (priority < request->_priority) {
+				_requests.erase(it);
+				request->_priority = priority;
+				queueRequest(request);
+			}
+			return request;
+		}
+	}
+
+	ResourceRequestPtr request(new ResourceRequest(fileName, priority));
+
+	// Cached resources are ready right away. Loading a missing resource
+	// would be a fatal error, so those aren't queued.
+	CacheMap::iterator it = _cacheMap.find(fileName);
+	if (it != _cacheMap.end())
+		request->_buffer = it->_value->buffer;
+	else if (!hasResource(fileName))
+		request->_failed = true;
+	else
+		queueRequest(request);
+
+	return request;
+}
+
+void ResourceManager::prefetch(const Common::StringArray &fileNames) {
+	for (uint i = 0; i < fileNames.size(); i++)
+		requestAsync(fileNames[i], kPrioritySpeculative);
+}
+
+void ResourceManager::queueRequest(const ResourceRequestPtr &request) {
+	// Keep the queue sorted by priority, and in request order within each priority
+	RequestList::iterator it = _requests.begin();
+	while (it != _requests.end() && (*it)->_priority <= request->_priority)
+		++it;
+
+	_requests.insert(it, request);
+}
+
+void ResourceManager::processRequests(uint32 timeBudget) {
+	uint32 start = g_system->getMillis();
+
+	// At least one request is handled on each call, so that loading always
+	// makes progress
+	while (!_requests.empty()) {
+		ResourceRequestPtr request = _requests.front();
+		_requests.pop_front();
+		request->_buffer = loadResourceBuffer(request->_fileName);
+
+		if (g_system->getMillis() - start >= timeBudget)
+			break;
+	}
+}
+
+void ResourceManager::waitForRequest(const ResourceRequestPtr &request) {
+	if (request->isReady() || request->isFailed())
+		return;
 
-	debug("Dumping %s size %d", fileName.c_str(), size);
+	_requests.remove(request);
+	request->_buffer = loadResourceBuffer(request->_fileName);
+}
+
+struct ArchiveOrderEntry {
+	uint index;
+	uint32 offset;
+};
+
+static bool compareArchiveOrder(const ArchiveOrderEntry &a, const ArchiveOrderEntry &b) {
+	return a.offset < b.offset;
+}
+
+void ResourceManager::getArchiveOrder(const Common::StringArray &fileNames, Common::Array<uint> &order) {
+	Common::Array<ArchiveOrderEntry> entries;
+	entries.resize(fileNames.size());
+
+	for (uint i = 0; i < fileNames.size(); i++) {
+		entries[i].index = i;
+		entries[i].offset = _isCD ? _archive->getMemberOffset(fileNames[i]) : 0;
+	}
+
+	// Reading the members in the order they're stored avoids seeking back
+	// and forth on slow media
+	if (_isCD)
+		Common::sort(entries.begin(), entries.end(), compareArchiveOrder);
+
+	order.resize(entries.size());
+	for (uint i = 0; i < entries.size(); i++)
+		order[i] = entries[i].index;
+}
+
+void ResourceManager::getResources(const Common::StringArray &fileNames, Common::Array<Common::SeekableReadStream *> &resources) {
+	Common::Array<uint> order;
+	getArchiveOrder(fileNames, order);
+
+	byte *packedData = new byte[0x10000];
+
+	resources.resize(fileNames.size());
+	for (uint i = 0; i < order.size(); i++) {
+		const Common::String &fileName = fileNames[order[i]];
+		ResourceBufferPtr buffer = getCachedResource(fileName);
+		if (buffer)
+			resources[order[i]] = new ResourceReadStream(buffer);
+		else
+			resources[order[i]] = unpackResource(openResource(fileName), fileName, packedData);
+	}
+
+	delete[] packedData;
+}
+
+void ResourceManager::listResources(Common::StringArray &fileNames) {
+	Common::ArchiveMemberList members;
+
+	if (_isCD)
+		_archive->listMembers(members);
+	else
+		SearchMan.listMatchingMembers(members, "*.hsq");
+
+	for (Common::ArchiveMemberList::const_iterator it = members.begin(); it != members.end(); ++it)
+		fileNames.push_back((*it)->getName());
+}
+
+Common::ReadStream *ResourceManager::getSequentialResource(Common::String fileName) {
+	Common::SeekableReadStream *rsrc = openResource(fileName);
+	uint16 unpackedSize;
+
+	if (!readHsqHeader(rsrc, fileName, unpackedSize))
+		return rsrc;
+
+	return new HsqReadStream(rsrc, DisposeAfterUse::YES);
+}
+
+ResourceBufferPtr ResourceManager::getCachedResource(const Common::String &fileName) {
+	CacheMap::iterator it = _cacheMap.find(fileName);
+	if (it == _cacheMap.end()) {
+		_cacheMisses++;
+		return ResourceBufferPtr();
+	}
+
+	// Move the resource to the front of the list
+	CacheEntry entry = *it->_value;
+	_cacheList.erase(it->_value);
+	_cacheList.push_front(entry);
+	it->_value = _cacheList.begin();
+
+	_cacheHits++;
+	return entry.buffer;
+}
+
+void ResourceManager::addCachedResource(const Common::String &fileName, const ResourceBufferPtr &buffer) {
+	if (buffer->size > _cacheBudget || _cacheMap.contains(fileName))
+		return;
+
+	evictCachedResources(_cacheBudget - buffer->size);
+
+	CacheEntry entry;
+	entry.fileName = fileName;
+	entry.buffer = buffer;
+	_cacheList.push_front(entry);
+	_cacheMap[fileName] = _cacheList.begin();
+	_cacheSize += buffer->size;
+}
 
+void ResourceManager::evictCachedResources(uint32 budget) {
+	while (_cacheSize > budget && !_cacheList.empty()) {
+		CacheEntry &entry = _cacheList.back();
+		_cacheSize -= entry.buffer->size;
+		_cacheMap.erase(entry.fileName);
+		_cacheList.pop_back();
+		_cacheEvictions++;
+	}
+}
+
+void ResourceManager::setCacheBudget(uint32 budget) {
+	_cacheBudget = budget;
+	evictCachedResources(_cacheBudget);
+}
+
+void ResourceManager::clearCache() {
+	_cacheList.clear();
+	_cacheMap.clear();
+	_cacheSize = 0;
+}
+
+void ResourceManager::enableDiskCache(const Common::String &fileName) {
+	delete _diskCache;
+	_diskCache = new ResourceDiskCache(fileName, getDataFingerprint());
+}
+
+uint32 ResourceManager::getDataFingerprint() {
+	if (_isCD)
+		return _archive->getFingerprint();
+
+	// Floppy resources are separate files, so the fingerprint is made from
+	// their names and sizes. The files are listed in no particular order, so
+	// the values of the files are added up.
+	Common::ArchiveMemberList members;
+	SearchMan.listMatchingMembers(members, "*.hsq");
+
+	uint32 fingerprint = 0;
+	for (Common::ArchiveMemberList::const_iterator it = members.begin(); it != members.end(); ++it) {
+		Common::String name = (*it)->getName();
+		name.toLowercase();
+
+		Common::SeekableReadStream *stream = (*it)->createReadStream();
+		byte size[4];
+		WRITE_LE_UINT32(size, stream ? stream->size() : 0);
+		delete stream;
+
+		fingerprint += checksumData(size, 4, checksumData((const byte *)name.c_str(), name.size()));
+	}
+
+	return fingerprint;
+}
+
+ResourceCacheStats ResourceManager::getCacheStats() const {
+	ResourceCacheStats stats;
+	stats.hits = _cacheHits;
+	stats.misses = _cacheMisses;
+	stats.evictions = _cacheEvictions;
+	stats.entries = _cacheMap.size();
+	stats.size = _cacheSize;
+	stats.budget = _cacheBudget;
+	return stats;
+}
+
+/**
+ * Writes a resource to <fileName>.raw, and deletes the stream
+ */
+static bool writeDumpFile(const Common::String &fileName, Common::ReadStream *rsrc) {
 	Common::DumpFile f;
-	if (f.open(fileName + ".raw")) {
-		f.write(data, size);
-		f.flush();
-		f.close();
+	if (!f.open(fileName + ".raw")) {
+		delete rsrc;
+		return false;
 	}
-	delete[] data;
+
+	// Resources which are unpacked on demand are unpacked while they're
+	// written, so only a small buffer is needed regardless of their size
+	byte data[4096];
+	uint32 size = 0;
+
+	while (!rsrc->eos()) {
+		uint32 count = rsrc->read(data, sizeof(data));
+		f.write(data, count);
+		size += count;
+	}
+
+	f.flush();
+	f.close();
+	delete rsrc;
+
+	debug("Dumped %s size %d", fileName.c_str(), size);
 
 	return true;
 }
 
+bool ResourceManager::dumpResource(Common::String fileName) {
+	return writeDumpFile(fileName, getSequentialResource(fileName));
+}
+
+uint ResourceManager::dumpResources(const Common::StringArray &fileNames) {
+	Common::Array<uint> order;
+	getArchiveOrder(fileNames, order);
+
+	// The resources are loaded in batches, so that dumping the whole archive
+	// doesn't keep all of it in memory
+	uint dumped = 0;
+	for (uint first = 0; first < order.size(); first += DUMP_BATCH_SIZE) {
+		Common::StringArray batch;
+		for (uint i = first; i < order.size() && i < first + DUMP_BATCH_SIZE; i++)
+			batch.push_back(fileNames[order[i]]);
+
+		Common::Array<Common::SeekableReadStream *> resources;
+		getResources(batch, resources);
+
+		for (uint i = 0; i < batch.size(); i++) {
+			if (writeDumpFile(batch[i], resources[i]))
+				dumped++;
+		}
+	}
+
+	return dumped;
+}
+
 } // End of namespace Cryo
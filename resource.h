@@ -23,7 +23,12 @@
 #ifndef CRYO_RESOURCE_H
 #define CRYO_RESOURCE_H
 
+#include "common/array.h"
+#include "common/hash-str.h"
+#include "common/list.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/str-array.h"
 #include "cryo/cryo.h"
 
 namespace Cryo {
@@ -33,42 +38,237 @@ class Archive;
 class DatArchive : public Common::Archive {
 public:
 	DatArchive(const Common::String &filename);
+	~DatArchive();
 
 	virtual bool hasFile(const Common::String &name) const;
 	virtual int listMembers(Common::ArchiveMemberList &list) const;
 	virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const;
+	/**
+	 * The returned stream reads from the archive's own file handle, so it
+	 * must be deleted before the archive is
+	 */
 	virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const;
 
-protected:
-	Common::SeekableReadStream *_stream;
+	uint32 getMemberOffset(const Common::String &name) const;
+
+	/**
+	 * Returns a value which changes whenever the archive's size or directory does
+	 */
+	uint32 getFingerprint() const { return _fingerprint; }
 
 	struct DatEntry {
+		uint32 hash;	// case insensitive hash of the file name
 		uint32 offset;
 		uint32 size;
 		char filename[16];
 	};
 
-	typedef Common::HashMap<Common::String, DatEntry*, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FileMap;
+protected:
+	const DatEntry *findEntry(const Common::String &name) const;
 
-	FileMap _files;
+	// Sorted by hash, so that lookups don't need to allocate anything
+	Common::Array<DatEntry> _files;
 	Common::String _datFilename;
+	Common::SeekableReadStream *_stream;
+	uint32 _fingerprint;
 };
 
 Common::Archive *makeDatArchive(const Common::String &name);
 
+/**
+ * An unpacked resource, shared by the resource cache and the streams reading it
+ */
+struct ResourceBuffer {
+	ResourceBuffer(byte *data_, uint32 size_) : data(data_), size(size_) {}
+	~ResourceBuffer() { free(data); }
+
+	byte *data;
+	uint32 size;
+};
+
+typedef Common::SharedPtr<ResourceBuffer> ResourceBufferPtr;
+
+/**
+ * A stream over a shared resource buffer. The buffer stays alive as long as
+ * the stream does, even if it's evicted from the cache in the meantime.
+ */
+class ResourceReadStream : public Common::MemoryReadStream {
+public:
+	ResourceReadStream(const ResourceBufferPtr &buffer)
+		: Common::MemoryReadStream(buffer->data, buffer->size), _buffer(buffer) {}
+
+private:
+	ResourceBufferPtr _buffer;
+};
+
+struct ResourceCacheStats {
+	uint32 hits;
+	uint32 misses;
+	uint32 evictions;
+	uint32 entries;
+	uint32 size;
+	uint32 budget;
+};
+
+enum ResourcePriority {
+	kPriorityImmediate,		// needed for the current frame
+	kPriorityNormal,
+	kPrioritySpeculative	// might be needed soon
+};
+
+/**
+ * A handle to a resource which is loaded by ResourceManager::processRequests()
+ * in the idle time of the engine's frames. It can be polled with isReady(),
+ * or waited for with ResourceManager::waitForRequest().
+ */
+class ResourceRequest {
+public:
+	ResourceRequest(const Common::String &fileName, ResourcePriority priority)
+		: _fileName(fileName), _priority(priority), _failed(false) {}
+
+	const Common::String &getFileName() const { return _fileName; }
+	bool isReady() const { return _buffer; }
+	/**
+	 * Returns true if the resource doesn't exist. Failed requests never
+	 * become ready.
+	 */
+	bool isFailed() const { return _failed; }
+
+	/**
+	 * Returns a stream over the loaded resource. Only valid when it's ready.
+	 */
+	Common::SeekableReadStream *createReadStream() const { return new ResourceReadStream(_buffer); }
+
+private:
+	friend class ResourceManager;
+
+	Common::String _fileName;
+	ResourcePriority _priority;
+	ResourceBufferPtr _buffer;
+	bool _failed;
+};
+
+typedef Common::SharedPtr<ResourceRequest> ResourceRequestPtr;
+
+class ResourceDiskCache;
+
 class ResourceManager {
 public:
 	ResourceManager(bool isCD);
 	~ResourceManager();
 
 	Common::SeekableReadStream *getResource(Common::String fileName);
+	/**
+	 * Returns the resource as it's stored, without unpacking it
+	 */
+	Common::SeekableReadStream *getRawResource(Common::String fileName);
+	bool hasResource(const Common::String &fileName) const;
+	/**
+	 * Returns a stream which unpacks the resource while it's being read,
+	 * for consumers which only need to read it from start to end.
+	 */
+	Common::ReadStream *getSequentialResource(Common::String fileName);
 	bool dumpResource(Common::String fileName);
 
+	/**
+	 * Loads several resources in one go, on the calling thread. The resources
+	 * are read in the order they're stored in the archive, cached ones are
+	 * taken from the cache, and a single buffer is used for all the packed
+	 * data. The streams are returned in the same order as fileNames.
+	 */
+	void getResources(const Common::StringArray &fileNames, Common::Array<Common::SeekableReadStream *> &resources);
+	/**
+	 * Dumps several resources, loading them in batches with getResources()
+	 */
+	uint dumpResources(const Common::StringArray &fileNames);
+	void listResources(Common::StringArray &fileNames);
+
+	/**
+	 * Packed resources which unpack to at least this many bytes are returned
+	 * by getResource() as streams that unpack on demand, instead of being
+	 * fully unpacked in memory. Members which aren't packed are read from
+	 * the file instead of being cached above the same size. 0 disables this.
+	 */
+	void setStreamingThreshold(uint32 threshold) { _streamingThreshold = threshold; }
+
+	/**
+	 * Unpacked resources are kept in a cache, so that loading them again is
+	 * cheap. When the cache grows over its budget (in bytes), the least
+	 * recently used resources are evicted.
+	 */
+	void setCacheBudget(uint32 budget);
+	void clearCache();
+	ResourceCacheStats getCacheStats() const;
+
+	/**
+	 * Also keeps unpacked resources in the given file in the save directory,
+	 * so that they don't need to be unpacked again in later sessions
+	 */
+	void enableDiskCache(const Common::String &fileName);
+
+	/**
+	 * Queues a resource to be loaded by processRequests(), and returns a
+	 * handle to it. Loaded resources are kept in the resource cache. The
+	 * request fails right away if the resource doesn't exist, so that
+	 * speculative requests can't stop the engine.
+	 */
+	ResourceRequestPtr requestAsync(const Common::String &fileName, ResourcePriority priority = kPriorityNormal);
+	void prefetch(const Common::StringArray &fileNames);
+
+	/**
+	 * Loads queued resources, most important first, until the time budget
+	 * (in milliseconds) is used up. This is meant to be called once per frame.
+	 */
+	void processRequests(uint32 timeBudget);
+
+	/**
+	 * Loads the given resource right away, if it's not loaded yet
+	 */
+	void waitForRequest(const ResourceRequestPtr &request);
+
 protected:
-	void hsqUnpack(Common::SeekableReadStream *inData, byte *outData);
+	Common::SeekableReadStream *openResource(const Common::String &fileName);
+	bool readHsqHeader(Common::SeekableReadStream *rsrc, const Common::String &fileName, uint16 &unpackedSize);
+	Common::SeekableReadStream *unpackResource(Common::SeekableReadStream *rsrc, const Common::String &fileName, byte *packedData);
+	ResourceBufferPtr unpackHsq(Common::SeekableReadStream *rsrc, const Common::String &fileName, uint16 unpackedSize, byte *packedData);
+	ResourceBufferPtr readRawResource(Common::SeekableReadStream *rsrc);
+	ResourceBufferPtr loadResourceBuffer(const Common::String &fileName);
+	void queueRequest(const ResourceRequestPtr &request);
+	void getArchiveOrder(const Common::StringArray &fileNames, Common::Array<uint> &order);
+	/**
+	 * Returns a value which changes whenever the game data files do
+	 */
+	uint32 getDataFingerprint();
+
+	ResourceBufferPtr getCachedResource(const Common::String &fileName);
+	void addCachedResource(const Common::String &fileName, const ResourceBufferPtr &buffer);
+	void evictCachedResources(uint32 budget);
 
 	bool _isCD;
 	DatArchive *_archive;
+	uint32 _streamingThreshold;
+
+	struct CacheEntry {
+		Common::String fileName;
+		ResourceBufferPtr buffer;
+	};
+
+	// The most recently used resources are at the front of the list
+	typedef Common::List<CacheEntry> CacheList;
+	typedef Common::HashMap<Common::String, CacheList::iterator, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> CacheMap;
+
+	CacheList _cacheList;
+	CacheMap _cacheMap;
+	uint32 _cacheSize;
+	uint32 _cacheBudget;
+	uint32 _cacheHits;
+	uint32 _cacheMisses;
+	uint32 _cacheEvictions;
+
+	ResourceDiskCache *_diskCache;
+
+	typedef Common::List<ResourceRequestPtr> RequestList;
+	RequestList _requests;
 };
 
 } // End of namespace Cryo
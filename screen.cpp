@@ -0,0 +1,126 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "graphics/pixelformat.h"
+
+#include "cryo/blit.h"
+#include "cryo/screen.h"
+
+namespace Cryo {
+
+Screen::Screen(OSystem *system) : _system(system), _palette(system) {
+	_updateStats.rects = 0;
+	_updateStats.pixels = 0;
+	_updateStats.fullScreen = false;
+
+	_surface.create(SCREEN_WIDTH, SCREEN_HEIGHT, Graphics::PixelFormat::createFormatCLUT8());
+	clear();
+	resetClipRect();
+}
+
+Screen::~Screen() {
+	_surface.free();
+}
+
+void Screen::setClipRect(const Common::Rect &rect) {
+	_clipRect = rect;
+	_clipRect.clip(SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+void Screen::resetClipRect() {
+	_clipRect = Common::Rect(SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+void Screen::clear(byte color) {
+	memset(_surface.getPixels(), color, _surface.pitch * _surface.h);
+	markDirty(Common::Rect(SCREEN_WIDTH, SCREEN_HEIGHT));
+}
+
+void Screen::drawFrame(const DecodedFrame &frame, int16 x, int16 y, bool flipX, bool flipY) {
+	markDirty(blitFrame(_surface, _clipRect, frame, x, y, flipX, flipY));
+}
+
+void Screen::markDirty(const Common::Rect &rect) {
+	Common::Rect dirty = rect;
+	dirty.clip(SCREEN_WIDTH, SCREEN_HEIGHT);
+	if (dirty.isEmpty())
+		return;
+
+	// Merge the rectangle with the ones it overlaps or touches. A merged
+	// rectangle can reach others, so the list is checked again after that.
+	bool merged = true;
+	while (merged) {
+		merged = false;
+
+		for (Common::List<Common::Rect>::iterator it = _dirtyRects.begin(); it != _dirtyRects.end(); ++it) {
+			if (dirty.left <= it->right && it->left <= dirty.right &&
+					dirty.top <= it->bottom && it->top <= dirty.bottom) {
+				dirty.extend(*it);
+				_dirtyRects.erase(it);
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	if (_dirtyRects.size() >= MAX_DIRTY_RECTS) {
+		for (Common::List<Common::Rect>::iterator it = _dirtyRects.begin(); it != _dirtyRects.end(); ++it)
+			dirty.extend(*it);
+		_dirtyRects.clear();
+	}
+
+	_dirtyRects.push_back(dirty);
+}
+
+void Screen::update() {
+	_palette.update();
+
+	uint32 coverage = 0;
+	for (Common::List<Common::Rect>::iterator it = _dirtyRects.begin(); it != _dirtyRects.end(); ++it)
+		coverage += it->width() * it->height();
+
+	_updateStats.fullScreen = coverage * 100 >= SCREEN_WIDTH * SCREEN_HEIGHT * FULL_UPLOAD_THRESHOLD;
+
+	if (_updateStats.fullScreen) {
+		_system->copyRectToScreen(_surface.getPixels(), _surface.pitch, 0, 0, _surface.w, _surface.h);
+		_updateStats.rects = 1;
+		_updateStats.pixels = SCREEN_WIDTH * SCREEN_HEIGHT;
+	} else {
+		for (Common::List<Common::Rect>::iterator it = _dirtyRects.begin(); it != _dirtyRects.end(); ++it) {
+			_system->copyRectToScreen(_surface.getBasePtr(it->left, it->top), _surface.pitch,
+					it->left, it->top, it->width(), it->height());
+		}
+		_updateStats.rects = _dirtyRects.size();
+		_updateStats.pixels = coverage;
+	}
+
+	if (_updateStats.rects)
+		debug(5, "Screen update: %d rects, %d pixels", _updateStats.rects, _updateStats.pixels);
+
+	_dirtyRects.clear();
+	_system->updateScreen();
+}
+
+} // End of namespace Cryo
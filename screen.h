@@ -0,0 +1,112 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_SCREEN_H
+#define CRYO_SCREEN_H
+
+#include "common/list.h"
+#include "common/rect.h"
+
+#include "graphics/surface.h"
+
+#include "cryo/palette.h"
+
+class OSystem;
+
+namespace Cryo {
+
+struct DecodedFrame;
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 200
+
+struct ScreenUpdateStats {
+	uint32 rects;	// rectangles uploaded by the last update
+	uint32 pixels;	// pixels uploaded by the last update
+	bool fullScreen;
+};
+
+/**
+ * The engine's back buffer. Everything is drawn into it, clipped to the
+ * current clip rectangle, and it's sent to the backend once per frame with
+ * update(). Only the parts which were drawn to since the last update are
+ * uploaded.
+ */
+class Screen {
+public:
+	enum {
+		// When the dirty rectangles cover this percentage of the screen, the
+		// whole screen is uploaded in one go instead
+		FULL_UPLOAD_THRESHOLD = 60,
+		// More dirty rectangles than this are merged into their bounding box
+		MAX_DIRTY_RECTS = 32
+	};
+
+	Screen(OSystem *system);
+	~Screen();
+
+	Graphics::Surface *getSurface() { return &_surface; }
+	Palette *getPalette() { return &_palette; }
+
+	/**
+	 * Restricts drawing to the given rectangle, which is clipped to the
+	 * screen bounds
+	 */
+	void setClipRect(const Common::Rect &rect);
+	void resetClipRect();
+	const Common::Rect &getClipRect() const { return _clipRect; }
+
+	void clear(byte color = 0);
+
+	/**
+	 * Draws the opaque pixels of a decoded frame at the given position,
+	 * optionally mirrored
+	 */
+	void drawFrame(const DecodedFrame &frame, int16 x, int16 y, bool flipX = false, bool flipY = false);
+
+	/**
+	 * Marks a part of the back buffer as changed, so that it's uploaded by
+	 * the next update. Overlapping and adjacent rectangles are merged.
+	 */
+	void markDirty(const Common::Rect &rect);
+
+	/**
+	 * Copies the changed parts of the back buffer and of the palette to the
+	 * backend, and shows the screen
+	 */
+	void update();
+
+	const ScreenUpdateStats &getUpdateStats() const { return _updateStats; }
+
+private:
+	OSystem *_system;
+	Graphics::Surface _surface;
+	Palette _palette;
+	Common::Rect _clipRect;
+
+	Common::List<Common::Rect> _dirtyRects;
+	ScreenUpdateStats _updateStats;
+};
+
+} // End of namespace Cryo
+
+#endif
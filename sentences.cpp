@@ -21,6 +21,7 @@
  */
 
 #include "common/memstream.h"
+#include "common/textconsole.h"
 
 #include "cryo/resource.h"
 #include "cryo/sentences.h"
@@ -29,34 +30,76 @@ namespace Cryo {
 
 Sentences::Sentences(Common::String filename, CryoEngine *engine) : _engine(engine) {
 	ResourceManager *resMan = _engine->getResourceManager();
-	_stream = resMan->getResource(filename);
-	uint16 firstSentence = _stream->readUint16LE();
-	_stream->seek(0);
-	_sentenceCount = firstSentence / 2;
+	Common::SeekableReadStream *stream = resMan->getResource(filename);
+
+	uint32 size = stream->size();
+	byte *data = new byte[size];
+	stream->read(data, size);
+	delete stream;
+
+	// The file starts with the offsets of the sentences, so the first of
+	// them also gives the size of the offset table
+	uint16 sentenceCount = (size >= 2) ? READ_LE_UINT16(data) / 2 : 0;
+	if (sentenceCount * 2 > size) {
+		warning("Sentences: %s has a truncated offset table", filename.c_str());
+		sentenceCount = size / 2;
+	}
+
+	_sentences.resize(sentenceCount);
+	_pool.reserve(size);
+
+	// Each sentence ends with a 0xFF marker, which is replaced by a 0 in
+	// the pool
+	for (uint16 i = 0; i < sentenceCount; i++) {
+		SentenceEntry &entry = _sentences[i];
+		uint32 start = MIN<uint32>(READ_LE_UINT16(data + i * 2), size);
+		uint32 end = start;
+		bool hasControlBytes = false;
+
+		while (end < size && data[end] != 0xFF) {
+			if (data[end] == 0x2E || data[end] == 0x0D)
+				hasControlBytes = true;
+			end++;
+		}
+
+		entry.offset = _pool.size();
+		entry.length = end - start;
+		for (uint32 pos = start; pos < end; pos++)
+			_pool.push_back(data[pos]);
+		_pool.push_back(0);
+
+		entry.printableOffset = entry.offset;
+		entry.printableLength = entry.length;
+
+		if (hasControlBytes) {
+			entry.printableOffset = _pool.size();
+			for (uint32 pos = start; pos < end; pos++) {
+				if (data[pos] != 0x2E && data[pos] != 0x0D)
+					_pool.push_back(data[pos]);
+			}
+			entry.printableLength = _pool.size() - entry.printableOffset;
+			_pool.push_back(0);
+		}
+	}
+
+	delete[] data;
 }
 
 Sentences::~Sentences() {
-	delete _stream;
 }
 
-Common::String Sentences::getSentence(uint16 index, bool printableOnly) {
-	assert(index <= _sentenceCount);
-
-	_stream->seek(index * 2);
-	uint16 start = _stream->readUint16LE();
-	_stream->seek(start);
-
-	// Keep reading till we find a 0xFF marker
-	Common::String sentence;
-	byte cur = 0;
-	
-	while(true) {
-		cur = _stream->readByte();
-		if ((cur == 0x2E || cur == 0x0D) && printableOnly)
-			continue;
-		if (cur == 0xFF)
-			break;
-		sentence += cur;
+SentenceView Sentences::getSentence(uint16 index, bool printableOnly) const {
+	assert(index < _sentences.size());
+
+	const SentenceEntry &entry = _sentences[index];
+	SentenceView sentence;
+
+	if (printableOnly) {
+		sentence.text = &_pool[entry.printableOffset];
+		sentence.length = entry.printableLength;
+	} else {
+		sentence.text = &_pool[entry.offset];
+		sentence.length = entry.length;
 	}
 
 	return sentence;
@@ -23,22 +23,59 @@
 #ifndef CRYO_SENTENCES_H
 #define CRYO_SENTENCES_H
 
+#include "common/array.h"
+#include "common/str.h"
+
 namespace Cryo {
 
+class CryoEngine;
+
+/**
+ * A sentence in the string pool of a phrase file. The text is 0 terminated,
+ * and stays valid for as long as the Sentences object it came from.
+ */
+struct SentenceView {
+	const char *text;
+	uint16 length;
+
+	const char *c_str() const { return text; }
+	uint size() const { return length; }
+	Common::String toString() const { return Common::String(text, length); }
+};
+
+/**
+ * The sentences of a phrase file. The offset table and the text of all the
+ * sentences are read when the file is loaded, so looking up a sentence
+ * doesn't access the resource or allocate memory.
+ */
 class Sentences {
 public:
 	Sentences(Common::String filename, CryoEngine *engine);
 	~Sentences();
 
-	uint16 count() const { return _sentenceCount; }
-	Common::String getSentence(uint16 index, bool printableOnly = false);
+	uint16 count() const { return _sentences.size(); }
+
+	/**
+	 * Returns a sentence. With printableOnly set, the 0x2E and 0x0D control
+	 * bytes are left out.
+	 */
+	SentenceView getSentence(uint16 index, bool printableOnly = false) const;
 
 private:
-	Common::SeekableReadStream *_stream;
-	uint16 _sentenceCount;
+	struct SentenceEntry {
+		uint32 offset;			// of the text in the pool
+		uint16 length;
+		uint32 printableOffset;	// the same as offset if there are no control bytes
+		uint16 printableLength;
+	};
+
+	Common::Array<SentenceEntry> _sentences;
+	// The text of all the sentences, followed by their printable versions
+	// where they differ
+	Common::Array<char> _pool;
 	CryoEngine *_engine;
 };
 
 } // End of namespace Cryo
- 
+
 #endif
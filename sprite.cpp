@@ -23,36 +23,40 @@
 #include "common/memstream.h"
 #include "common/system.h"
 #include "common/debug.h"
-#include "graphics/palette.h"
+#include "common/util.h"
 
+#include "cryo/blit.h"
 #include "cryo/resource.h"
+#include "cryo/screen.h"
 #include "cryo/sprite.h"
 
 namespace Cryo {
 
-Sprite::Sprite(Common::String filename, CryoEngine *engine) : _engine(engine) {
+Sprite::Sprite(Common::String filename, CryoEngine *engine) : _name(filename), _engine(engine) {
 	ResourceManager *resMan = _engine->getResourceManager();
 	_stream = resMan->getResource(filename);
+	readHeaders();
 }
 
-Sprite::Sprite(Common::SeekableReadStream *stream, CryoEngine *engine) : _engine(engine), _stream(stream) {
-
+Sprite::Sprite(Common::SeekableReadStream *stream, CryoEngine *engine) : _stream(stream), _engine(engine) {
+	readHeaders();
 }
 
 Sprite::~Sprite() {
 	delete _stream;
 }
 
-void Sprite::setPalette() {
+void Sprite::readHeaders() {
 	// The first chunk is the palette chunk
 	_stream->seek(0);
 	uint16 chunkSize = _stream->readUint16LE();
-	uint16 curPos = 2;
 
 	if (chunkSize > _stream->size())
 		error("Sprite file is corrupted");
 
-	while (curPos < chunkSize) {
+	memset(_palette, 0, sizeof(_palette));
+
+	while (_stream->pos() + 2 <= chunkSize) {
 		byte palStart = _stream->readByte();
 		byte palCount = _stream->readByte();
 
@@ -64,126 +68,377 @@ void Sprite::setPalette() {
 			continue;
 		}
 
-		byte *palChunk = new byte[palCount * 3];	// RGB
-		for (uint i = 0; i < palCount; i++) {
-			if (i + palStart > 256)
-				break;
-			palChunk[i * 3 + 0] = _stream->readByte() << 2;	// R
-			palChunk[i * 3 + 1] = _stream->readByte() << 2;	// G
-			palChunk[i * 3 + 2] = _stream->readByte() << 2;	// B
+		PaletteRange range;
+		range.start = palStart;
+		range.count = MIN<uint16>(palCount, 256 - palStart);
+
+		// The palette is stored as 6-bit VGA values
+		byte *pal = _palette + palStart * 3;
+		for (uint i = 0; i < range.count * 3; i++)
+			*pal++ = _stream->readByte() << 2;
+		_stream->skip((palCount - range.count) * 3);
+
+		_paletteRanges.push_back(range);
+	}
+
+	// The second chunk is the frame chunk, a list of 16-bit offsets. The
+	// first one is the size of the list.
+	uint32 frameTableStart = chunkSize;
+	_stream->seek(frameTableStart);
+	uint16 frameCount = (_stream->readUint16LE() - 2) / 2;
+
+	Common::Array<uint16> offsets;
+	offsets.resize(frameCount);
+	for (uint16 i = 0; i < frameCount; i++)
+		offsets[i] = _stream->readUint16LE();
+
+	_frames.resize(frameCount);
+	for (uint16 i = 0; i < frameCount; i++) {
+		FrameInfo &info = _frames[i];
+		info.offset = offsets[i];
+		if (frameTableStart + info.offset + 4 > (uint32)_stream->size())
+			error("Sprite frame %d is out of bounds", i);
+
+		_stream->seek(frameTableStart + info.offset);
+
+		info.flags = _stream->readUint16LE();
+		info.isCompressed = info.flags & 0x8000;
+		info.flipX = info.flags & 0x4000;
+		info.flipY = info.flags & 0x2000;
+		info.width = info.flags & 0x01FF;
+		info.height = _stream->readByte();
+		info.palOffset = _stream->readSByte();
+		info.dataOffset = frameTableStart + info.offset + 4;
+
+		// width must be divisible by 4
+		while (info.width % 4 != 0)
+			info.width++;
+	}
+}
+
+void Sprite::setPalette() {
+	Palette *palette = _engine->getScreen()->getPalette();
+
+	for (uint i = 0; i < _paletteRanges.size(); i++) {
+		const PaletteRange &range = _paletteRanges[i];
+		palette->setColors(_palette + range.start * 3, range.start, range.count);
+	}
+}
+
+void Sprite::getPalette(byte *palette) const {
+	for (uint i = 0; i < _paletteRanges.size(); i++) {
+		const PaletteRange &range = _paletteRanges[i];
+		memcpy(palette + range.start * 3, _palette + range.start * 3, range.count * 3);
+	}
+}
+
+const FrameInfo &Sprite::getFrameInfo(uint16 frameIndex) const {
+	assert (frameIndex < _frames.size());
+	return _frames[frameIndex];
+}
+
+void Sprite::drawFrame(uint16 frameIndex, int16 x, int16 y, bool flipX) {
+	Screen *screen = _engine->getScreen();
+	screen->markDirty(drawFrame(*screen->getSurface(), screen->getClipRect(), frameIndex, x, y, flipX));
+}
+
+Common::Rect Sprite::drawFrame(Graphics::Surface &surface, const Common::Rect &clip, uint16 frameIndex,
+		int16 x, int16 y, bool flipX) {
+	// Mirrored frames are stored like the others, and are mirrored while
+	// they're drawn, so both orientations share the decoded data
+	const FrameInfo &info = getFrameInfo(frameIndex);
+	flipX = (flipX != info.flipX);
+
+	// Sprites which aren't cached are drawn without an intermediate buffer
+	if (_name.empty() || !_engine->getFrameCache())
+		return drawFrameDirect(surface, clip, info, x, y, flipX, info.flipY);
+
+	DecodedFramePtr frame = getFrame(frameIndex);
+	return blitFrame(surface, clip, *frame, x, y, flipX, info.flipY);
+}
+
+// The RLE decoding kernels are specialized for the properties of a frame
+// which don't change between pixels, so that their loops don't test them.
+// The right one is picked once per frame. Data is stored in half bytes, with
+// a simple RLE compression: a positive count is followed by count + 1 bytes,
+// a negative one by a single byte which is repeated -count + 1 times.
+
+#define MAX_RUN_SIZE 129
+
+static inline uint readRunCount(Common::SeekableReadStream *stream, bool &fillSingleValue) {
+	int8 repetition = stream->readSByte();
+	fillSingleValue = (repetition < 0);
+	return ((repetition < 0) ? -repetition : repetition) + 1;
+}
+
+static inline void readRun(Common::SeekableReadStream *stream, byte *run, uint count, bool fillSingleValue) {
+	if (fillSingleValue)
+		memset(run, stream->readByte(), count);
+	else
+		stream->read(run, count);
+}
+
+/**
+ * Decodes an RLE packed frame into a buffer and its transparency mask
+ */
+template<bool kHasOffset>
+static void decodeRleFrame(Common::SeekableReadStream *stream, const FrameInfo &info, byte *pixels, byte *mask) {
+	uint32 totalSize = info.width * info.height;
+	uint32 cur = 0;
+	byte run[MAX_RUN_SIZE];
+
+	while (cur < totalSize) {
+		bool fillSingleValue;
+		uint count = readRunCount(stream, fillSingleValue);
+		readRun(stream, run, count, fillSingleValue);
+		uint32 runEnd = MIN<uint32>(cur + count * 2, totalSize);
+
+		// Transparent pixels are 0 in both the pixels and the mask, so they
+		// can be written without a test
+		for (uint i = 0; cur < runEnd; i++, cur += 2) {
+			byte pix1 = run[i] & 0xf;
+			byte pix2 = run[i] >> 4;
+			byte mask1 = pix1 ? 0xFF : 0;
+			byte mask2 = pix2 ? 0xFF : 0;
+
+			pixels[cur] = (kHasOffset ? (byte)(pix1 + info.palOffset) : pix1) & mask1;
+			pixels[cur + 1] = (kHasOffset ? (byte)(pix2 + info.palOffset) : pix2) & mask2;
+			mask[cur] = mask1;
+			mask[cur + 1] = mask2;
 		}
-		_engine->_system->getPaletteManager()->setPalette(palChunk, palStart, palCount);
-		delete[] palChunk;
 	}
 }
 
-uint16 Sprite::getFrameCount() {
-	// The second chunk is the frame chunk, a list of 16-bit offsets
-	_stream->seek(0);
+/**
+ * Removes the RLE compression of a frame, keeping its pixels at 4bpp
+ */
+static void unpackRleFrame(Common::SeekableReadStream *stream, const FrameInfo &info, byte *pixels) {
+	uint32 totalSize = info.width * info.height / 2;
+	uint32 cur = 0;
 
-	uint16 chunkSize = _stream->readUint16LE();
-	_stream->seek(chunkSize);
-	chunkSize = _stream->readUint16LE();
+	while (cur < totalSize) {
+		bool fillSingleValue;
+		uint count = readRunCount(stream, fillSingleValue);
+		uint32 runSize = MIN<uint32>(count, totalSize - cur);
+
+		if (fillSingleValue) {
+			memset(pixels + cur, stream->readByte(), runSize);
+		} else {
+			stream->read(pixels + cur, runSize);
+			stream->skip(count - runSize);
+		}
 
-	return (chunkSize - 2) / 2;
+		cur += runSize;
+	}
+}
+
+typedef void (*RleDecoder)(Common::SeekableReadStream *stream, const FrameInfo &info, byte *pixels, byte *mask);
+
+static const RleDecoder rleDecoders[2] = {
+	decodeRleFrame<false>, decodeRleFrame<true>
+};
+
+template<bool kClipped, bool kHasOffset, bool kFlipped>
+static inline void drawRlePixel(byte *screen, uint16 pitch, const FrameInfo &info, int16 x, int16 rowOrigin,
+		int16 rowStep, uint16 col, uint16 row, const Common::Rect &clip, byte pixel) {
+	if (!pixel)
+		return;
+
+	if (kClipped && !clip.contains(col, row))
+		return;
+
+	int16 screenX = kFlipped ? (x + info.width - 1 - col) : (x + col);
+	screen[(rowOrigin + rowStep * row) * pitch + screenX] = kHasOffset ? (byte)(pixel + info.palOffset) : pixel;
+}
+
+/**
+ * Decodes an RLE packed frame straight into a surface. The clip rectangle is
+ * relative to the frame, and is mirrored along with it. Row r of the frame is
+ * drawn on screen row rowOrigin + rowStep * r, which mirrors the frame
+ * vertically when rowStep is -1.
+ */
+template<bool kClipped, bool kHasOffset, bool kFlipped>
+static void drawRleFrame(Common::SeekableReadStream *stream, const FrameInfo &info,
+		Graphics::Surface &surface, int16 x, int16 rowOrigin, int16 rowStep, const Common::Rect &clip) {
+	byte *screen = (byte *)surface.getPixels();
+	uint32 totalSize = info.width * info.height;
+	// Nothing past the last visible row needs to be decoded
+	uint32 visibleEnd = kClipped ? MIN<uint32>(clip.bottom * info.width, totalSize) : totalSize;
+	uint32 cur = 0;
+	byte run[MAX_RUN_SIZE];
+
+	while (cur < visibleEnd) {
+		bool fillSingleValue;
+		uint count = readRunCount(stream, fillSingleValue);
+		uint32 runEnd = MIN<uint32>(cur + count * 2, totalSize);
+
+		uint16 col = cur % info.width;
+		uint16 row = cur / info.width;
+
+		if (kClipped) {
+			// Skip runs which don't cover any pixel inside of the clip rectangle
+			uint16 lastCol = (runEnd - 1) % info.width;
+			uint16 lastRow = (runEnd - 1) / info.width;
+			bool visible = true;
+
+			if (lastRow < clip.top || row >= clip.bottom)
+				visible = false;
+			else if (row == lastRow && (lastCol < clip.left || col >= clip.right))
+				visible = false;
+			else if (row + 1 == lastRow && col >= clip.right && lastCol < clip.left)
+				visible = false;
+
+			if (!visible) {
+				stream->skip(fillSingleValue ? 1 : count);
+				cur = runEnd;
+				continue;
+			}
+		}
+
+		readRun(stream, run, count, fillSingleValue);
+
+		// Frame widths are multiples of 4, so both pixels of a byte are
+		// always on the same row
+		for (uint i = 0; cur < runEnd; i++, cur += 2) {
+			if (col == info.width) {
+				col = 0;
+				row++;
+			}
+
+			drawRlePixel<kClipped, kHasOffset, kFlipped>(screen, surface.pitch, info, x, rowOrigin, rowStep, col, row, clip, run[i] & 0xf);
+			drawRlePixel<kClipped, kHasOffset, kFlipped>(screen, surface.pitch, info, x, rowOrigin, rowStep, col + 1, row, clip, run[i] >> 4);
+			col += 2;
+		}
+	}
 }
 
-FrameInfo Sprite::getFrameInfo(uint16 frameIndex) {
-	FrameInfo result;
-	// First, get the frame count
-	// This will place the pointer at the start of the frame table
-	uint16 frameCount = getFrameCount();
-	uint16 chunkStart = _stream->pos() - 2;
-	assert (frameIndex < frameCount);
+typedef void (*RleDrawer)(Common::SeekableReadStream *stream, const FrameInfo &info,
+		Graphics::Surface &surface, int16 x, int16 rowOrigin, int16 rowStep, const Common::Rect &clip);
+
+static const RleDrawer rleDrawers[2][2][2] = {
+	{
+		{ drawRleFrame<false, false, false>, drawRleFrame<false, false, true> },
+		{ drawRleFrame<false, true, false>, drawRleFrame<false, true, true> }
+	},
+	{
+		{ drawRleFrame<true, false, false>, drawRleFrame<true, false, true> },
+		{ drawRleFrame<true, true, false>, drawRleFrame<true, true, true> }
+	}
+};
+
+Common::Rect Sprite::drawFrameDirect(Graphics::Surface &surface, const Common::Rect &surfaceClip, const FrameInfo &info,
+		int16 x, int16 y, bool flipX, bool flipY) {
+	// The clip rectangle, relative to the frame
+	Common::Rect clip = surfaceClip;
+	clip.clip(surface.w, surface.h);
+	clip.translate(-x, -y);
+	clip.clip(Common::Rect(info.width, info.height));
+	if (clip.isEmpty())
+		return Common::Rect();
+
+	Common::Rect dirty = clip;
+	dirty.translate(x, y);
+
+	bool clipped = (clip != Common::Rect(info.width, info.height));
+
+	// From here on, the clip rectangle is in the orientation of the data
+	if (flipX)
+		clip = Common::Rect(info.width - clip.right, clip.top, info.width - clip.left, clip.bottom);
+	if (flipY)
+		clip = Common::Rect(clip.left, info.height - clip.bottom, clip.right, info.height - clip.top);
 
-	// Now, get the offset of the frame
-	_stream->skip(frameIndex * 2);
-	result.offset = _stream->readUint16LE();
-	_stream->seek(chunkStart + result.offset);
-	
-	uint16 infos = _stream->readUint16LE();
-	if (infos & 0x4000)
-		error("Unsupported compression 0x4000 !");
+	int16 rowOrigin = flipY ? (y + info.height - 1) : y;
+	int16 rowStep = flipY ? -1 : 1;
+
+	_stream->seek(info.dataOffset);
+
+	if (info.isCompressed) {
+		rleDrawers[clipped][info.palOffset != 0][flipX](_stream, info, surface, x, rowOrigin, rowStep, clip);
+		return dirty;
+	}
+
+	// Only the visible rows are read, and only the visible part of them is
+	// expanded, starting from an even pixel to keep whole bytes
+	uint16 rowSize = info.width / 2;
+	uint16 start = clip.left & ~1;
+	uint16 end = (clip.right + 1) & ~1;
+	byte *packed = new byte[rowSize];
+	byte *pixels = new byte[info.width];
+
+	_stream->skip(clip.top * rowSize);
+
+	for (int16 row = clip.top; row < clip.bottom; row++) {
+		_stream->read(packed, rowSize);
+		expandNibbles(packed + start / 2, pixels + start, end - start, info.palOffset);
+
+		byte *dst = (byte *)surface.getBasePtr(dirty.left, rowOrigin + rowStep * row);
+		if (flipX) {
+			for (int16 col = clip.right - 1; col >= clip.left; col--)
+				*dst++ = pixels[col];
+		} else {
+			memcpy(dst, pixels + clip.left, clip.width());
+		}
+	}
 
-	if (infos & 0x2000)
-		error("Unsupported compression 0x2000 !");
+	delete[] packed;
+	delete[] pixels;
 
-	result.isCompressed = infos & 0x8000;
-	result.width = infos & 0x01FF;
-	result.height = _stream->readByte();
-	result.palOffset = _stream->readSByte();
+	return dirty;
+}
 
-	// width must be divisible by 4
-	while (result.width % 4 != 0)
-		result.width++;
+DecodedFramePtr Sprite::getFrame(uint16 frameIndex) {
+	FrameCache *frameCache = _engine->getFrameCache();
+	if (_name.empty() || !frameCache)
+		return DecodedFramePtr(decodeFrame(frameIndex));
+
+	FrameKey key;
+	key.spriteName = _name;
+	key.frameIndex = frameIndex;
+	key.palOffset = getFrameInfo(frameIndex).palOffset;
+
+	DecodedFramePtr frame = frameCache->get(key);
+	if (!frame) {
+		frame = DecodedFramePtr(decodeFrame(frameIndex, frameCache->getPackedFrames()));
+		frame->buildSpans();
+		frameCache->add(key, frame);
+	}
 
-	return result;
+	return frame;
 }
 
-void Sprite::drawFrame(uint16 frameIndex, uint16 x, uint16 y) {
-	FrameInfo info = getFrameInfo(frameIndex);
-	// The pointer is now at the beginning of the frame data
+DecodedFrame *Sprite::decodeFrame(uint16 frameIndex, bool packed) {
+	const FrameInfo &info = getFrameInfo(frameIndex);
 	assert (info.width > 0 && info.height > 0);
 
+	_stream->seek(info.dataOffset);
+
 	uint32 totalSize = info.width * info.height;
 
-	byte *rect = new byte[totalSize];
-	memset(rect, 0, totalSize);
-	byte *dst = rect;
-	uint32 cur = 0;
-	byte pixel;
-	int count;
+	DecodedFrame *frame = new DecodedFrame(info.width, info.height, packed);
 
-	if (!info.isCompressed) {
+	if (packed) {
+		frame->palOffset = info.palOffset;
+		frame->opaque = !info.isCompressed;
+
+		if (info.isCompressed)
+			unpackRleFrame(_stream, info, frame->pixels);
+		else
+			_stream->read(frame->pixels, totalSize / 2);
+	} else if (!info.isCompressed) {
+		// Data is stored in half bytes
 		byte *buf = new byte[totalSize / 2];
 		_stream->read(buf, totalSize / 2);
-		while (cur < totalSize) {
-			pixel = buf[cur / 2];
-			// Data is stored in half bytes
-			*dst++ = (pixel & 0xf) + info.palOffset;
-			*dst++ = (pixel >> 4) + info.palOffset;
-			cur += 2;
-			if (cur >= totalSize)
-				break;
-		}
+		expandNibbles(buf, frame->pixels, totalSize, info.palOffset);
 		delete[] buf;
+
+		// Uncompressed frames have no transparent pixels
+		memset(frame->mask, 0xFF, totalSize);
+		frame->opaque = true;
 	} else {
-		while (cur < totalSize) {
-			// Data is stored in half bytes, with a simple RLE compression
-			int8 repetition = _stream->readSByte();
-			bool fillSingleValue = (repetition < 0);
-			count = ((repetition < 0) ? -repetition : repetition) + 1;
-			pixel = fillSingleValue ? _stream->readByte() : 0;
-
-			for (int i = 0; i < count; i++) {
-				if (!fillSingleValue)
-					pixel = _stream->readByte();
-
-				byte pix1 = pixel & 0xf;
-				byte pix2 = pixel >> 4;
-
-				if (pix1) {
-					*dst++ = pix1 + info.palOffset;
-				} else {
-					dst++;
-				}
-
-				if (pix2) {
-					*dst++ = pix2 + info.palOffset;
-				} else {
-					dst++;
-				}
-
-				cur += 2;
-				if (cur >= totalSize)
-					break;
-			}
-		}
+		rleDecoders[info.palOffset != 0](_stream, info, frame->pixels, frame->mask);
 	}
-	
-	_engine->_system->copyRectToScreen(rect, info.width, x, y, info.width, info.height);
 
-	delete[] rect;
+	return frame;
 }
 
 } // End of namespace Cryo
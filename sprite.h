@@ -23,13 +23,21 @@
 #ifndef CRYO_SPRITE_H
 #define CRYO_SPRITE_H
 
+#include "common/array.h"
+
 #include "cryo/cryo.h"
+#include "cryo/framecache.h"
+#include "cryo/palette.h"
 
 namespace Cryo {
 
 struct FrameInfo {
-	uint16 offset;
+	uint16 offset;		// from the start of the frame table
+	uint32 dataOffset;	// of the pixel data, from the start of the file
+	uint16 flags;
 	bool isCompressed;
+	bool flipX;			// drawn mirrored horizontally
+	bool flipY;			// drawn mirrored vertically
 	uint16 width;
 	uint16 height;
 	int8 palOffset;
@@ -41,13 +49,74 @@ public:
 	Sprite(Common::SeekableReadStream *stream, CryoEngine *engine);
 	~Sprite();
 
+	/**
+	 * Sets the colors of the sprite in the engine's palette. They're sent
+	 * to the backend with the next screen update.
+	 */
 	void setPalette();
-	uint16 getFrameCount();
-	FrameInfo getFrameInfo(uint16 frameIndex);
-	void drawFrame(uint16 frameIndex, uint16 x = 0, uint16 y = 0);
+
+	/**
+	 * Copies the colors of the sprite into a 256 color RGB palette, for
+	 * example to fade to them. The other colors are left untouched.
+	 */
+	void getPalette(byte *palette) const;
+	uint16 getFrameCount() const { return _frames.size(); }
+	const FrameInfo &getFrameInfo(uint16 frameIndex) const;
+
+	/**
+	 * Draws a frame into the back buffer, clipped to its clip rectangle.
+	 * Transparent pixels leave the back buffer untouched. Frames which are
+	 * flagged as mirrored in the sprite file are mirrored, and flipX mirrors
+	 * them (again) horizontally.
+	 */
+	void drawFrame(uint16 frameIndex, int16 x = 0, int16 y = 0, bool flipX = false);
+
+	/**
+	 * Draws a frame into any surface, clipped to the given rectangle
+	 *
+	 * @return                    The area of the surface which was drawn to
+	 */
+	Common::Rect drawFrame(Graphics::Surface &surface, const Common::Rect &clip, uint16 frameIndex,
+			int16 x, int16 y, bool flipX = false);
+
+	/**
+	 * Returns a decoded frame. Frames of sprites which were loaded by name
+	 * are kept in the frame cache of the engine, so they're only decoded
+	 * the first time they're needed.
+	 */
+	DecodedFramePtr getFrame(uint16 frameIndex);
+
+	/**
+	 * Decodes a frame to 8bpp, or only removes its RLE compression if packed
+	 * is set, bypassing the frame cache. The returned frame must be deleted
+	 * by the caller.
+	 */
+	DecodedFrame *decodeFrame(uint16 frameIndex, bool packed = false);
 
 private:
+	/**
+	 * Reads the palette and the frame table, which are kept in memory
+	 */
+	void readHeaders();
+
+	/**
+	 * Decodes a frame straight into a surface. Runs of pixels which are
+	 * outside of the clip rectangle are skipped without being decoded.
+	 */
+	Common::Rect drawFrameDirect(Graphics::Surface &surface, const Common::Rect &clip, const FrameInfo &info,
+			int16 x, int16 y, bool flipX, bool flipY);
+
 	Common::SeekableReadStream *_stream;
+	Common::String _name;	// empty for sprites which aren't cached
+
+	struct PaletteRange {
+		uint16 start;
+		uint16 count;
+	};
+
+	byte _palette[PALETTE_SIZE];
+	Common::Array<PaletteRange> _paletteRanges;
+	Common::Array<FrameInfo> _frames;
 
 	CryoEngine *_engine;
 };
@@ -0,0 +1,233 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "cryo/font.h"
+#include "cryo/text.h"
+
+namespace Cryo {
+
+/**
+ * Adds a line of words to a layout. The words are separated by single
+ * spaces, which take the width of a space of the font.
+ */
+static void addLine(const Font &font, TextLayout &layout, const Common::Array<Common::String> &words, int16 y) {
+	int16 x = 0;
+
+	for (uint w = 0; w < words.size(); w++) {
+		if (w > 0)
+			x += font.getCharWidth(' ');
+
+		const Common::String &word = words[w];
+		for (uint i = 0; i < word.size(); i++) {
+			GlyphPosition glyph;
+			glyph.c = word[i];
+			glyph.x = x;
+			glyph.y = y;
+			layout.glyphs.push_back(glyph);
+			x += font.getCharWidth(glyph.c);
+		}
+	}
+
+	layout.width = MAX<uint16>(layout.width, x);
+	layout.lineCount++;
+}
+
+TextLayoutPtr layoutText(const Font &font, const Common::String &text, uint16 maxWidth) {
+	TextLayoutPtr layout(new TextLayout());
+	layout->width = 0;
+	layout->lineCount = 0;
+
+	uint16 spaceWidth = font.getCharWidth(' ');
+	uint16 lineHeight = font.getHeight();
+
+	Common::Array<Common::String> words;
+	Common::String word;
+	uint16 lineWidth = 0;	// of the words of the current line
+	uint16 wordWidth = 0;
+	int16 y = 0;
+
+	for (uint i = 0; i <= text.size(); i++) {
+		byte c = (i < text.size()) ? text[i] : '\n';
+
+		if (c != ' ' && c != '\n' && c != '\r') {
+			word += c;
+			wordWidth += font.getCharWidth(c);
+			continue;
+		}
+
+		if (!word.empty()) {
+			// Start a new line if the word doesn't fit on this one. Words
+			// which are wider than the box get a line of their own.
+			uint16 width = words.empty() ? wordWidth : lineWidth + spaceWidth + wordWidth;
+			if (maxWidth && width > maxWidth && !words.empty()) {
+				addLine(font, *layout, words, y);
+				y += lineHeight;
+				words.clear();
+				width = wordWidth;
+			}
+
+			words.push_back(word);
+			lineWidth = width;
+			word.clear();
+			wordWidth = 0;
+		}
+
+		if (c == '\n' || c == '\r') {
+			addLine(font, *layout, words, y);
+			y += lineHeight;
+			words.clear();
+			lineWidth = 0;
+
+			// "\r\n" is a single line break
+			if (c == '\r' && i + 1 < text.size() && text[i + 1] == '\n')
+				i++;
+		}
+	}
+
+	layout->height = y;
+	return layout;
+}
+
+TextLayoutCache::TextLayoutCache() {
+}
+
+TextLayoutCache::~TextLayoutCache() {
+}
+
+TextLayoutPtr TextLayoutCache::get(const Font &font, const Common::String &text, uint16 maxWidth) {
+	LayoutKey key;
+	key.text = text;
+	key.maxWidth = maxWidth;
+
+	CacheMap::iterator it = _map.find(key);
+	if (it != _map.end()) {
+		// Move the layout to the front of the list
+		CacheEntry entry = *it->_value;
+		_list.erase(it->_value);
+		_list.push_front(entry);
+		it->_value = _list.begin();
+		return entry.layout;
+	}
+
+	if (_map.size() >= MAX_ENTRIES) {
+		_map.erase(_list.back().key);
+		_list.pop_back();
+	}
+
+	CacheEntry entry;
+	entry.key = key;
+	entry.layout = layoutText(font, text, maxWidth);
+	_list.push_front(entry);
+	_map[key] = _list.begin();
+
+	return entry.layout;
+}
+
+void TextLayoutCache::clear() {
+	_list.clear();
+	_map.clear();
+}
+
+TextCache::TextCache() : _size(0), _budget(DEFAULT_BUDGET), _hits(0), _misses(0), _evictions(0) {
+}
+
+TextCache::~TextCache() {
+}
+
+DecodedFramePtr TextCache::get(const RenderedTextKey &key) {
+	CacheMap::iterator it = _map.find(key);
+	if (it == _map.end()) {
+		_misses++;
+		return DecodedFramePtr();
+	}
+
+	// Move the text to the front of the list
+	CacheEntry entry = *it->_value;
+	_list.erase(it->_value);
+	_list.push_front(entry);
+	it->_value = _list.begin();
+
+	_hits++;
+	return entry.text;
+}
+
+void TextCache::add(const RenderedTextKey &key, const DecodedFramePtr &text) {
+	uint32 textSize = text->getMemorySize();
+	if (textSize > _budget || _map.contains(key))
+		return;
+
+	evict(_budget - textSize);
+
+	CacheEntry entry;
+	entry.key = key;
+	entry.text = text;
+	_list.push_front(entry);
+	_map[key] = _list.begin();
+	_size += textSize;
+}
+
+void TextCache::invalidate(const Font *font) {
+	CacheList::iterator it = _list.begin();
+	while (it != _list.end()) {
+		if (it->key.font == font) {
+			_size -= it->text->getMemorySize();
+			_map.erase(it->key);
+			it = _list.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void TextCache::evict(uint32 budget) {
+	while (_size > budget && !_list.empty()) {
+		CacheEntry &entry = _list.back();
+		_size -= entry.text->getMemorySize();
+		_map.erase(entry.key);
+		_list.pop_back();
+		_evictions++;
+	}
+}
+
+void TextCache::setBudget(uint32 budget) {
+	_budget = budget;
+	evict(_budget);
+}
+
+void TextCache::clear() {
+	_list.clear();
+	_map.clear();
+	_size = 0;
+}
+
+ResourceCacheStats TextCache::getStats() const {
+	ResourceCacheStats stats;
+	stats.hits = _hits;
+	stats.misses = _misses;
+	stats.evictions = _evictions;
+	stats.entries = _map.size();
+	stats.size = _size;
+	stats.budget = _budget;
+	return stats;
+}
+
+} // End of namespace Cryo
@@ -0,0 +1,189 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef CRYO_TEXT_H
+#define CRYO_TEXT_H
+
+#include "common/array.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/ptr.h"
+#include "common/str.h"
+
+#include "cryo/framecache.h"
+
+namespace Cryo {
+
+class Font;
+
+/**
+ * The position of a character of a laid out string, relative to the top
+ * left corner of the text
+ */
+struct GlyphPosition {
+	byte c;
+	int16 x;
+	int16 y;
+};
+
+/**
+ * A string broken into lines, with the position of each visible character.
+ * Spaces and line breaks have no glyphs.
+ */
+struct TextLayout {
+	Common::Array<GlyphPosition> glyphs;
+	uint16 width;	// of the widest line
+	uint16 height;
+	uint16 lineCount;
+};
+
+typedef Common::SharedPtr<TextLayout> TextLayoutPtr;
+
+/**
+ * Breaks text into lines no wider than maxWidth, at spaces where possible.
+ * A maxWidth of 0 only breaks lines at line breaks.
+ */
+TextLayoutPtr layoutText(const Font &font, const Common::String &text, uint16 maxWidth);
+
+/**
+ * Keeps the layouts of the most recently used strings of a font, so that
+ * text which is shown for many frames is only laid out once
+ */
+class TextLayoutCache {
+public:
+	enum {
+		MAX_ENTRIES = 64
+	};
+
+	TextLayoutCache();
+	~TextLayoutCache();
+
+	/**
+	 * Returns the layout of the given text, laying it out if it isn't in
+	 * the cache
+	 */
+	TextLayoutPtr get(const Font &font, const Common::String &text, uint16 maxWidth);
+	void clear();
+
+private:
+	struct LayoutKey {
+		Common::String text;
+		uint16 maxWidth;
+
+		bool operator==(const LayoutKey &key) const {
+			return maxWidth == key.maxWidth && text == key.text;
+		}
+	};
+
+	struct LayoutKey_Hash {
+		uint operator()(const LayoutKey &key) const {
+			return Common::hashit(key.text.c_str()) ^ key.maxWidth;
+		}
+	};
+
+	struct CacheEntry {
+		LayoutKey key;
+		TextLayoutPtr layout;
+	};
+
+	typedef Common::List<CacheEntry> CacheList;
+	typedef Common::HashMap<LayoutKey, CacheList::iterator, LayoutKey_Hash> CacheMap;
+
+	CacheList _list;	// the most recently used layout is at the front
+	CacheMap _map;
+};
+
+struct RenderedTextKey {
+	const Font *font;
+	Common::String text;
+	byte color;
+	uint16 maxWidth;
+
+	bool operator==(const RenderedTextKey &key) const {
+		return font == key.font && color == key.color && maxWidth == key.maxWidth && text == key.text;
+	}
+};
+
+struct RenderedTextKey_Hash {
+	uint operator()(const RenderedTextKey &key) const {
+		return Common::hashit(key.text.c_str()) ^ (key.maxWidth << 8) ^ key.color ^ (uint)(size_t)key.font;
+	}
+};
+
+/**
+ * Keeps recently drawn strings rendered to 8bpp, with the spans of their
+ * opaque pixels, so that text which stays on the screen for many frames is
+ * drawn with a single blit. The least recently used strings are evicted
+ * when the cache grows over its budget.
+ *
+ * The rendered pixels are palette indices, so they stay valid when the
+ * palette changes. The strings of a font are removed when it's deleted.
+ */
+class TextCache {
+public:
+	enum {
+		DEFAULT_BUDGET = 64 * 1024
+	};
+
+	TextCache();
+	~TextCache();
+
+	/**
+	 * Returns the rendered text for the given key, or a NULL pointer if the
+	 * text is not in the cache
+	 */
+	DecodedFramePtr get(const RenderedTextKey &key);
+	void add(const RenderedTextKey &key, const DecodedFramePtr &text);
+
+	/**
+	 * Removes all the strings of a font
+	 */
+	void invalidate(const Font *font);
+
+	void setBudget(uint32 budget);
+	void clear();
+	ResourceCacheStats getStats() const;
+
+private:
+	void evict(uint32 budget);
+
+	struct CacheEntry {
+		RenderedTextKey key;
+		DecodedFramePtr text;
+	};
+
+	typedef Common::List<CacheEntry> CacheList;
+	typedef Common::HashMap<RenderedTextKey, CacheList::iterator, RenderedTextKey_Hash> CacheMap;
+
+	CacheList _list;	// the most recently used string is at the front
+	CacheMap _map;
+	uint32 _size;
+	uint32 _budget;
+	uint32 _hits;
+	uint32 _misses;
+	uint32 _evictions;
+};
+
+} // End of namespace Cryo
+
+#endif